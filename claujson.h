@@ -11,12 +11,24 @@
 #include <charconv>
 
 #include <map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 #include <set>
 #include <fstream>
 #include <iomanip>
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <queue>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
 //#include <Windows.h>
 
 
@@ -28,46 +40,591 @@ namespace claujson {
 
 	class UserType;
 
+	// bump allocator for strings of Data ( and child arrays, container records of UserType ), one per parse thread ( not thread safe ), blocks are freed at once.
+	// a string is [uint32_t length][chars]['\0'], Data has a pointer to chars.
+	class StringArena {
+	public:
+		static const size_t HEADER_SIZE = sizeof(uint32_t);
+		static const size_t FIRST_BLOCK_SIZE = 4 * 1024;
+		static const size_t MAX_BLOCK_SIZE = 4 * 1024 * 1024;
+	private:
+		std::vector<char*> blocks; // malloc-ed.
+		char* now = nullptr;
+		size_t left = 0;
+		size_t next_block_size = FIRST_BLOCK_SIZE;
+		size_t capacity = 0; // sum of block sizes.
+		size_t alloc_size = 0; // bytes from Alloc ( child lists, container records ), the others are strings.
+	public:
+		StringArena() { }
+
+		StringArena(const StringArena&) = delete;
+		StringArena& operator=(const StringArena&) = delete;
+
+		StringArena(StringArena&& other) noexcept {
+			Swap(other);
+		}
+
+		StringArena& operator=(StringArena&& other) noexcept {
+			if (this != &other) {
+				Clear();
+				Swap(other);
+			}
+			return *this;
+		}
+
+		~StringArena() {
+			Clear();
+		}
+
+		void Clear() {
+			for (auto* x : blocks) {
+				free(x);
+			}
+			blocks.clear();
+			now = nullptr;
+			left = 0;
+			next_block_size = FIRST_BLOCK_SIZE;
+			capacity = 0;
+			alloc_size = 0;
+		}
+
+		size_t get_block_num() const {
+			return blocks.size();
+		}
+
+		size_t get_capacity() const {
+			return capacity;
+		}
+
+		size_t get_alloc_size() const {
+			return alloc_size;
+		}
+
+		// space for a string of max_len chars ( + SIMDJSON_PADDING, simdjson writes 32 bytes at once )
+		// write chars to the returned pointer, then Commit.
+		char* Reserve(size_t max_len) {
+			const size_t n = HEADER_SIZE + max_len + SIMDJSON_PADDING;
+			if (n > left) {
+				NewBlock(n);
+			}
+			return now + HEADER_SIZE;
+		}
+
+		// str is from the last Reserve.
+		char* Commit(char* str, size_t len) {
+			const uint32_t x = uint32_t(len);
+			std::memcpy(str - HEADER_SIZE, &x, HEADER_SIZE);
+			str[len] = '\0';
+			const size_t n = HEADER_SIZE + len + 1;
+			now += n;
+			left -= n;
+			return str;
+		}
+
+		char* Copy(const char* str, size_t len) {
+			char* x = Reserve(len);
+			std::memcpy(x, str, len);
+			return Commit(x, len);
+		}
+
+		// n bytes, aligned for pointers.
+		void* Alloc(size_t n) {
+			size_t pad = (alignof(void*) - reinterpret_cast<uintptr_t>(now) % alignof(void*)) % alignof(void*);
+			if (pad + n > left) {
+				NewBlock(n);
+				pad = 0;
+			}
+			char* x = now + pad;
+			now += pad + n;
+			left -= pad + n;
+			alloc_size += pad + n;
+			return x;
+		}
+
+		// string not in an arena, ex) set_str_val without arena.
+		static char* NewString(const char* str, size_t len) {
+			char* x = new char[HEADER_SIZE + len + 1] + HEADER_SIZE;
+			const uint32_t _len = uint32_t(len);
+			std::memcpy(x - HEADER_SIZE, &_len, HEADER_SIZE);
+			std::memcpy(x, str, len);
+			x[len] = '\0';
+			return x;
+		}
+
+		static void DeleteString(char* str) {
+			delete[] (str - HEADER_SIZE);
+		}
+
+		static size_t Length(const char* str) {
+			uint32_t x;
+			std::memcpy(&x, str - HEADER_SIZE, HEADER_SIZE);
+			return x;
+		}
+	private:
+		void NewBlock(size_t n) {
+			size_t size = next_block_size;
+			if (size < n) {
+				size = n;
+			}
+			char* x = (char*)malloc(size);
+			if (!x) {
+				throw std::bad_alloc(); // not exit, it runs on workers of a ThreadPool.
+			}
+			blocks.push_back(x);
+			now = x;
+			left = size;
+			capacity += size;
+			if (next_block_size < MAX_BLOCK_SIZE) {
+				next_block_size *= 2;
+			}
+		}
+
+		void Swap(StringArena& other) {
+			std::swap(blocks, other.blocks);
+			std::swap(now, other.now);
+			std::swap(left, other.left);
+			std::swap(next_block_size, other.next_block_size);
+			std::swap(capacity, other.capacity);
+			std::swap(alloc_size, other.alloc_size);
+		}
+	};
+
+	// interned keys, same key -> same string ( of an arena in the table ), thread safe.
+	// keys of a document are in its KeyTable with Parser::set_intern_keys(true)
+	class KeyTable {
+	private:
+		static const size_t SHARD_NUM = 64;
+
+		struct Shard {
+			std::mutex lock;
+			std::unordered_set<std::string_view> keys; // views of strings in arena.
+			StringArena arena;
+		};
+
+		mutable Shard shards[SHARD_NUM];
+
+		Shard& get_shard(std::string_view str) const {
+			return shards[std::hash<std::string_view>()(str) % SHARD_NUM];
+		}
+	public:
+		KeyTable() { }
+
+		KeyTable(const KeyTable&) = delete;
+		KeyTable& operator=(const KeyTable&) = delete;
+
+		char* Intern(std::string_view str) {
+			Shard& shard = get_shard(str);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			auto iter = shard.keys.find(str);
+			if (iter != shard.keys.end()) {
+				return const_cast<char*>(iter->data());
+			}
+			char* x = shard.arena.Copy(str.data(), str.size());
+			shard.keys.insert(std::string_view(x, str.size()));
+			return x;
+		}
+
+		// nullptr : no key is str.
+		const char* Find(std::string_view str) const {
+			Shard& shard = get_shard(str);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			auto iter = shard.keys.find(str);
+			return iter != shard.keys.end() ? iter->data() : nullptr;
+		}
+
+		size_t size() const {
+			size_t sum = 0;
+			for (auto& shard : shards) {
+				std::lock_guard<std::mutex> guard(shard.lock);
+				sum += shard.keys.size();
+			}
+			return sum;
+		}
+
+		// arenas and hash sets, the nodes of the sets are estimated.
+		size_t get_bytes() const {
+			size_t sum = sizeof(KeyTable);
+			for (auto& shard : shards) {
+				std::lock_guard<std::mutex> guard(shard.lock);
+				sum += shard.arena.get_capacity();
+				sum += shard.keys.bucket_count() * sizeof(void*);
+				sum += shard.keys.size() * (sizeof(std::string_view) + 2 * sizeof(void*));
+			}
+			return sum;
+		}
+	};
+
+	// KeyTable for one parse thread, keys seen before are found without lock.
+	class KeyCache {
+	private:
+		KeyTable* table = nullptr;
+		std::unordered_set<std::string_view> keys; // views of strings in table.
+	public:
+		explicit KeyCache(KeyTable* table = nullptr) : table(table) { }
+
+		KeyTable* get_table() const {
+			return table;
+		}
+
+		char* Intern(const char* str, size_t len) {
+			auto iter = keys.find(std::string_view(str, len));
+			if (iter != keys.end()) {
+				return const_cast<char*>(iter->data());
+			}
+			char* x = table->Intern(std::string_view(str, len));
+			keys.insert(std::string_view(x, len));
+			return x;
+		}
+	};
+
 	class Block { // Memory? Block
 	public:
 		int64_t start = 0;
 		int64_t size = 0;
+		UserType* pool = nullptr; // start is index in pool, nullptr -> PoolManager`s (first) pool.
+	};
+
+	// memory of a node pool, n zeroed nodes. calloc, or huge pages ( mmap, see simdjson::dom::huge_page_mode )
+	// pools from NewPool are freed by FreePool. ( PoolManager::Clear does it )
+	inline UserType* NewPool(int64_t n, simdjson::dom::huge_page_mode mode = simdjson::dom::huge_page_mode::off);
+	inline void FreePool(UserType* pool);
+
+	// node order in the pool made by Compact.
+	enum class NodeOrder {
+		DFS, // pre-order, like parse. a subtree is contiguous.
+		BFS // children of a node are contiguous, levels one by one.
+	};
+
+	// memory of a document ( and of its Parser ), in bytes. see PoolManager::memory_usage, Parser::memory_usage
+	struct MemoryUsage {
+		size_t nodes = 0; // node pools and slabs, nodes not from a pool.
+		size_t child_lists = 0; // children arrays and container records ( see UserType::Container ), in arenas or on the heap.
+		size_t strings = 0; // string arenas, KeyTable, strings on the heap.
+		size_t stage1 = 0; // simdjson structural indexes and string buffer. ( Parser only )
+		size_t input = 0; // the input buffer. ( Parser only )
+		size_t indexes = 0; // key indexes of objects. ( with the tree walk only )
+
+		size_t total() const {
+			return nodes + child_lists + strings + stage1 + input + indexes;
+		}
+
+		// child lists and container records are from StringArena::Alloc, the rest of the blocks is strings. ( and unused space )
+		void AddArena(const StringArena& arena) {
+			child_lists += arena.get_alloc_size();
+			strings += arena.get_capacity() - arena.get_alloc_size();
+		}
 	};
 
+	// node allocator of a document. ( all nodes are one size, so one size class )
+	//   free nodes are in the dead list and free blocks, Alloc and DeAlloc are O(1),
+	//   if there is no free node, a new slab is allocated ( 64 nodes, doubling up to 64K nodes ).
+	//   Alloc and DeAlloc lock, threads that edit a lot should use a Cache each.
 	class PoolManager {
-	private:
-		UserType* pool = nullptr;
-		std::vector<Block> blocks;
-		UserType* dead_list_start = nullptr;
-		std::vector<UserType*> outOfPool;
 	public:
-		enum class Type {
+		enum class Type : uint8_t {
 			FROM_STATIC = 0, // no dynamic allocation.
-			FROM_POOL, // calloc + free
-			FROM_NEW   // new + delete.
+			FROM_POOL, // in pools, constructed.
+			DEAD // in pools, destroyed. ( dead list, or destroyed by DestroyNodes )
+		};
+
+		// the number of nodes, for monitoring.
+		struct Stats {
+			int64_t live_nodes = 0; // constructed nodes. ( exact if the sizes of all pools are known )
+			int64_t free_nodes = 0; // in the dead list and free blocks.
+			int64_t cached_nodes = 0; // in Caches, as of their last refill or return.
+			int64_t pool_num = 0; // pools from parse.
+			int64_t slab_num = 0; // pools from Alloc.
+			int64_t bytes = 0; // pools of known size and slabs.
 		};
 
+		static const int64_t FIRST_SLAB_SIZE = 64;
+		static const int64_t MAX_SLAB_SIZE = 64 * 1024;
+
+		class Cache;
+	private:
+		std::vector<UserType*> pools; // NewPool-ed. ( from parse, and slabs )
+		std::vector<int64_t> pool_sizes; // the number of nodes in pools[i], 0 : unknown.
+		std::vector<Block> blocks; // free ranges.
+		size_t block_idx = 0; // blocks[0 ~ block_idx) are empty.
+		UserType* dead_list_start = nullptr;
+		std::vector<StringArena> arenas; // strings of the nodes.
+		std::unique_ptr<KeyTable> key_table; // interned keys of the nodes.
+
+		std::mutex mtx; // for Alloc, DeAlloc and Caches. ( not moved )
+		int64_t next_slab_size = FIRST_SLAB_SIZE;
+		int64_t capacity = 0; // nodes in pools of known size.
+		int64_t free_num = 0;
+		int64_t cached_num = 0;
+		int64_t slab_num = 0;
+	public:
 		explicit PoolManager() { }
 
-		explicit PoolManager(UserType* pool, std::vector<Block>&& blocks) {
-			this->pool = pool;
+		// pool_size : the number of nodes in pool, 0 : unknown, then its nodes are not in Stats and DestroyNodes.
+		explicit PoolManager(UserType* pool, std::vector<Block>&& blocks, int64_t pool_size = 0) {
+			this->pools.push_back(pool);
+			this->pool_sizes.push_back(pool_size);
+			this->blocks = std::move(blocks);
+			for (auto& x : this->blocks) {
+				if (!x.pool) {
+					x.pool = pool;
+				}
+			}
+			Count();
+		}
+
+		// pool segments, ex) from ParsePipelined.
+		explicit PoolManager(std::vector<UserType*>&& pools, std::vector<Block>&& blocks, std::vector<int64_t> pool_sizes = {}) {
+			this->pools = std::move(pools);
 			this->blocks = std::move(blocks);
+			this->pool_sizes = std::move(pool_sizes);
+			this->pool_sizes.resize(this->pools.size(), 0);
+			Count();
+		}
+
+		PoolManager(const PoolManager&) = delete;
+		PoolManager& operator=(const PoolManager&) = delete;
+
+		PoolManager(PoolManager&& other) noexcept {
+			Take(other);
+		}
+
+		// the old nodes are freed, like Clear.
+		PoolManager& operator=(PoolManager&& other) noexcept {
+			if (this != &other) {
+				Clear();
+				Take(other);
+			}
+			return *this;
 		}
 
+		// free all, destructors of live nodes are not called. ( DestroyNodes before, if they own memory )
 		inline void Clear();
 
+		// destroy the live nodes in pools of known size, then all nodes are free.
+		inline void DestroyNodes();
+
+		// pools and free blocks -> caller, ( string arenas are kept, deleted by Clear )
+		//   the dead list is given as blocks of one node.
+		inline void Release(std::vector<UserType*>& pools, std::vector<Block>& blocks);
+
 		// init - first time only Blocks... -> no Blocks... ?
 		void AddBlock(uint64_t start, uint64_t size) {
-			Block block{ start, size };
+			std::lock_guard<std::mutex> guard(mtx);
+			Block block{ (int64_t)start, (int64_t)size, pools.empty() ? nullptr : pools[0] };
 			blocks.push_back(block);
+			free_num += block.size;
+		}
+
+		// strings of the nodes are in arena, it is freed by Clear.
+		void AddArena(StringArena&& arena) {
+			arenas.push_back(std::move(arena));
+		}
+
+		// keys of the nodes are in key_table, it is freed by Clear.
+		void SetKeyTable(std::unique_ptr<KeyTable>&& key_table) {
+			this->key_table = std::move(key_table);
+		}
+
+		// nullptr : keys are not interned.
+		const KeyTable* get_key_table() const {
+			return key_table.get();
+		}
+
+		inline Stats get_stats();
+
+		// pools, slabs, arenas and key_table. root != nullptr : also the heap strings, heap child lists
+		//   and nodes not from a pool in the tree of root. ( O(n), the tree should not be edited meanwhile )
+		inline MemoryUsage memory_usage(const UserType* root = nullptr);
+
+		// a constructed node ( type -1 ), from the dead list, free blocks or a new slab.
+		inline UserType* Alloc();
+		// n constructed nodes -> out, the lock is taken once.
+		inline void Alloc(UserType** out, int64_t n);
+		// destroy ut and add it to the dead list. ( FROM_STATIC - nothing )
+		inline void DeAlloc(UserType* ut);
+	private:
+		// free memory -> linked list of at most n nodes, not constructed.
+		inline UserType* TakeFree(int64_t n);
+		inline UserType* TakeOne();
+		inline void AddSlab();
+		inline void Count();
+		inline void Take(PoolManager& other);
+	};
+
+	// per thread cache of free nodes, for editing one document from many threads. ( one Cache per thread )
+	//   refills and returns BATCH nodes at once, so the lock of the PoolManager is rarely taken.
+	class PoolManager::Cache {
+	public:
+		static const int64_t BATCH = 64;
+	private:
+		PoolManager* manager;
+		UserType* free_list = nullptr; // linked by next_dead, not constructed.
+		int64_t free_num = 0;
+		int64_t synced_num = 0; // free_num, last seen by the manager.
+	public:
+		explicit Cache(PoolManager& manager) : manager(&manager) { }
+
+		Cache(const Cache&) = delete;
+		Cache& operator=(const Cache&) = delete;
+
+		~Cache() {
+			Flush();
 		}
 
 		inline UserType* Alloc();
 		inline void DeAlloc(UserType* ut);
+
+		// cached nodes -> PoolManager. ( before Clear, DestroyNodes or Release of the PoolManager )
+		inline void Flush() {
+			Return(free_num);
+		}
+	private:
+		inline void Return(int64_t n);
 	};
 
 
-	UserType* ChkPool(UserType*& node, PoolManager& manager);
+	// long-lived worker threads, reused by Parse. ( no thread create/join per parse. )
+	// one ThreadPool can be shared by many parses at the same time, each parse waits only its own tasks.
+	// do not call Parse from inside a task of the same ThreadPool. (can deadlock)
+	class ThreadPool {
+	private:
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> tasks;
+		std::mutex mtx;
+		std::condition_variable cv;
+		bool stop = false;
+	public:
+		explicit ThreadPool(int thr_num = 0) {
+			if (thr_num <= 0) {
+				thr_num = std::thread::hardware_concurrency();
+			}
+			if (thr_num <= 0) {
+				thr_num = 1;
+			}
+
+			workers.reserve(thr_num);
+			for (int i = 0; i < thr_num; ++i) {
+				workers.emplace_back([this]() { this->Run(); });
+			}
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		~ThreadPool() {
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				stop = true;
+			}
+			cv.notify_all();
+			for (auto& x : workers) {
+				x.join();
+			}
+		}
+
+		size_t size() const {
+			return workers.size();
+		}
+
+		template <class F>
+		std::future<void> Enqueue(F&& f) {
+			auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+			std::future<void> result = task->get_future();
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				tasks.emplace([task]() { (*task)(); });
+			}
+			cv.notify_one();
+			return result;
+		}
+
+		// call f(0) .. f(n - 1) on worker_num workers and wait. ( for all, then an exception of f is thrown here )
+		// jobs are given to workers in order, [0, n/worker_num) to first worker, ...
+		// a worker takes its jobs from the front of its deque, when empty it steals from the back of others.
+		template <class F>
+		void ParallelFor(int64_t n, int worker_num, F&& f) {
+			if (n <= 0) {
+				return;
+			}
+			if (worker_num <= 0 || worker_num > (int)workers.size()) {
+				worker_num = (int)workers.size();
+			}
+			if (worker_num > n) {
+				worker_num = (int)n;
+			}
+
+			std::vector<WorkDeque> deques(worker_num);
+			for (int64_t i = 0; i < n; ++i) {
+				deques[i * worker_num / n].jobs.push_back(i);
+			}
+
+			std::vector<std::future<void>> result(worker_num);
+			for (int w = 0; w < worker_num; ++w) {
+				result[w] = Enqueue([&deques, &f, w, worker_num]() {
+					int64_t job;
+					while (Pop(deques, w, worker_num, job)) {
+						f(job);
+					}
+				});
+			}
+			for (auto& x : result) {
+				x.wait(); // f and deques are used until all are done.
+			}
+			for (auto& x : result) {
+				x.get();
+			}
+		}
+
+		// shared by Parse calls that do not pass their own ThreadPool.
+		static ThreadPool& Default() {
+			static ThreadPool pool;
+			return pool;
+		}
+
+	private:
+		struct WorkDeque {
+			std::mutex mtx;
+			std::deque<int64_t> jobs;
+		};
+
+		static bool Pop(std::vector<WorkDeque>& deques, int w, int worker_num, int64_t& job) {
+			{
+				std::unique_lock<std::mutex> lock(deques[w].mtx);
+				if (!deques[w].jobs.empty()) {
+					job = deques[w].jobs.front();
+					deques[w].jobs.pop_front();
+					return true;
+				}
+			}
+			// steal.
+			for (int k = 1; k < worker_num; ++k) {
+				WorkDeque& victim = deques[(w + k) % worker_num];
+				std::unique_lock<std::mutex> lock(victim.mtx);
+				if (!victim.jobs.empty()) {
+					job = victim.jobs.back();
+					victim.jobs.pop_back();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void Run() {
+			while (true) {
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(mtx);
+					cv.wait(lock, [this]() { return stop || !tasks.empty(); });
+					if (stop && tasks.empty()) {
+						return;
+					}
+					task = std::move(tasks.front());
+					tasks.pop();
+				}
+				task();
+			}
+		}
+	};
 
 
 	class StringPtr {
@@ -139,49 +696,68 @@ namespace claujson {
 		}
 	};
 
+	// 16 bytes, no vtable. the payload is in a union, type says which one is used.
 	class Data {
 	public:
+		union {
+			long long int_val = 0;
+			unsigned long long uint_val;
+			double float_val;
+			char* str_val; // STRING or KEY, a string of StringArena ( length is before it ), use get_str_val() / set_str_val().
+		};
+
 		simdjson::internal::tape_type type;
 
 		bool is_key = false;
-
-		long long int_val = 0;
-		unsigned long long uint_val = 0;
-		double float_val = 0;
 	private:
-		std::string* str_val = nullptr; // const
+		bool str_owned = false; // str_val is from StringArena::NewString, else in an arena ( of the document )
+		bool str_interned = false; // str_val is in a KeyTable, same key -> same str_val.
+
+		bool has_str() const {
+			return type == simdjson::internal::tape_type::STRING || type == simdjson::internal::tape_type::KEY;
+		}
+
+		void free_str() {
+			if (has_str() && str_val && str_owned) {
+				StringArena::DeleteString(str_val);
+			}
+			if (has_str()) {
+				str_val = nullptr;
+			}
+			str_owned = false;
+			str_interned = false;
+		}
+
+		// not STRING or KEY -> becomes STRING.
+		void to_str() {
+			if (!has_str()) {
+				type = simdjson::internal::tape_type::STRING;
+				str_val = nullptr;
+				str_owned = false;
+				str_interned = false;
+			}
+		}
 	public:
 		void clear() {
+			free_str();
+			int_val = 0;
 			type = simdjson::internal::tape_type::ROOT;
 			is_key = false;
-			int_val = 0;
-			uint_val = 0;
-			float_val = 0;
-			if (str_val) {
-				str_val->clear();
-			}
 		}
 
-		const std::string* get_str_val() const {
-			return str_val;
+		std::string_view get_str_val() const {
+			if (has_str() && str_val) {
+				return std::string_view(str_val, StringArena::Length(str_val));
+			}
+			return std::string_view();
 		}
 
 		void set_str_val(const std::string& str) {
-			if (str_val) {
-				*str_val = str;
-			}
-			else {
-				str_val = new std::string(str);
-			}
+			set_str_val(str.data(), str.size());
 		}
 
 		void set_str_val(std::string&& str) {
-			if (str_val) {
-				*str_val = std::move(str);
-			}
-			else {
-				str_val = new std::string(std::move(str));
-			}
+			set_str_val(str.data(), str.size());
 		}
 
 		void set_str_val(uint8_t* str, size_t len) {
@@ -189,32 +765,69 @@ namespace claujson {
 		}
 
 		void set_str_val(const char* str, size_t len) {
-			if (str_val) {
-				str_val->assign(str, len);
-			}
-			else {
-				str_val = new std::string(str, len);
-			}
+			char* x = StringArena::NewString(str, len); // str can be str_val.
+			to_str();
+			free_str();
+			str_val = x;
+			str_owned = true;
+		}
+
+		// copy into arena, arena must live longer than this Data.
+		void set_str_val(const char* str, size_t len, StringArena& arena) {
+			set_arena_str_val(arena.Copy(str, len));
+		}
+
+		// str is already in an arena. ( StringArena::Reserve + Commit )
+		void set_arena_str_val(char* str) {
+			to_str();
+			free_str();
+			str_val = str;
+		}
+
+		// str is from KeyTable::Intern.
+		void set_interned_str_val(char* str) {
+			to_str();
+			free_str();
+			str_val = str;
+			str_interned = true;
+		}
+
+		bool is_interned() const {
+			return has_str() && str_interned;
+		}
+
+		// bytes of the string on the heap, 0 : in an arena ( or a KeyTable ), or not a string.
+		size_t get_heap_size() const {
+			return has_str() && str_val && str_owned ? StringArena::HEADER_SIZE + StringArena::Length(str_val) + 1 : 0;
 		}
 
-		virtual ~Data() {
-			if (str_val) {
-				delete str_val;
+		// copy the string out of its arena ( or KeyTable ), then this Data does not need the arena.
+		void own_str_val() {
+			if (has_str() && str_val && !str_owned) {
+				str_val = StringArena::NewString(str_val, StringArena::Length(str_val));
+				str_owned = true;
+				str_interned = false;
 			}
 		}
 
+		~Data() {
+			free_str();
+		}
+
 		Data(const Data& other)
-			: type(other.type), int_val(other.int_val), uint_val(other.uint_val), float_val(other.float_val), is_key(other.is_key) {
-			if (type == simdjson::internal::tape_type::KEY || type == simdjson::internal::tape_type::STRING) {
-				str_val = new std::string(*other.str_val);
+			: uint_val(other.uint_val), type(other.type), is_key(other.is_key) {
+			if (has_str() && other.str_val) {
+				str_val = StringArena::NewString(other.str_val, StringArena::Length(other.str_val));
+				str_owned = true;
 			}
 		}
 
 		Data(Data&& other) noexcept
-			: type(other.type), int_val(other.int_val), uint_val(other.uint_val), float_val(other.float_val), is_key(other.is_key) {
-			if (type == simdjson::internal::tape_type::KEY || type == simdjson::internal::tape_type::STRING) {
-				str_val = other.str_val;
+			: uint_val(other.uint_val), type(other.type), is_key(other.is_key), str_owned(other.str_owned), str_interned(other.str_interned) {
+			if (has_str()) {
 				other.str_val = nullptr;
+				other.str_owned = false;
+				other.str_interned = false;
 			}
 		}
 
@@ -224,7 +837,7 @@ namespace claujson {
 			if (this->type == other.type) {
 				switch (this->type) {
 				case simdjson::internal::tape_type::STRING:
-					return *this->str_val == *other.str_val;
+					return this->get_str_val() == other.get_str_val();
 					break;
 				}
 				return true;
@@ -236,7 +849,7 @@ namespace claujson {
 			if (this->type == other.type) {
 				switch (this->type) {
 				case simdjson::internal::tape_type::STRING:
-					return *this->str_val < *other.str_val;
+					return this->get_str_val() < other.get_str_val();
 					break;
 				}
 			}
@@ -248,18 +861,13 @@ namespace claujson {
 				return *this;
 			}
 
+			free_str();
+
 			this->type = other.type;
-			this->int_val = other.int_val;
 			this->uint_val = other.uint_val;
-			this->float_val = other.float_val;
-			if (other.str_val) {
-				set_str_val(*other.str_val);
-			}
-			else {
-				if (this->str_val) {
-					delete this->str_val;
-				}
-				this->str_val = nullptr;
+			if (has_str() && other.str_val) {
+				this->str_val = StringArena::NewString(other.str_val, StringArena::Length(other.str_val));
+				this->str_owned = true;
 			}
 			this->is_key = other.is_key;
 
@@ -273,11 +881,10 @@ namespace claujson {
 			}
 
 			std::swap(this->type, other.type);
-			std::swap(this->int_val, other.int_val);
 			std::swap(this->uint_val, other.uint_val);
-			std::swap(this->float_val, other.float_val);
-			std::swap(this->str_val, other.str_val);
 			std::swap(this->is_key, other.is_key);
+			std::swap(this->str_owned, other.str_owned);
+			std::swap(this->str_interned, other.str_interned);
 
 			return *this;
 		}
@@ -295,7 +902,7 @@ namespace claujson {
 				stream << data.float_val;
 				break;
 			case simdjson::internal::tape_type::STRING:
-				stream << (*data.str_val);
+				stream << data.get_str_val();
 				break;
 			case simdjson::internal::tape_type::TRUE_VALUE:
 				stream << "true";
@@ -429,9 +1036,33 @@ namespace simdjson {
 
 	};
 
+	// after the closing quote of the string at buf[idx], idx2 : a token after it.
+	//   idx2 can be far, a projection drops the tokens of skipped members. ( then the quote is searched )
+	inline uint64_t StringEnd(const char* buf, uint64_t idx, uint64_t idx2) {
+		if (idx2 - idx <= 256) {
+			return idx2;
+		}
+		const char* p = buf + idx + 1;
+		while (const char* quote = static_cast<const char*>(std::memchr(p, '"', buf + idx2 - p))) {
+			const char* x = quote;
+			while (x[-1] == '\\') { // the opening quote stops it.
+				--x;
+			}
+			if ((quote - x) % 2 == 0) {
+				return uint64_t(quote + 1 - buf);
+			}
+			p = quote + 1;
+		}
+		return idx2;
+	}
+
 	// todo - add bool is_key ...
+	// arena - not nullptr : strings are unescaped into arena, ( not into string_buf and then copied )
+	// keys - not nullptr : keys are interned.
+	// wrong value -> data.type == ROOT ( cleared ), callers check it. ( no exit, it can run on workers of a ThreadPool )
 	inline ::claujson::Data& Convert(::claujson::Data& data, uint64_t idx, uint64_t idx2, uint64_t len, bool key, 
-									const std::unique_ptr<char[]>& buf, const std::unique_ptr<uint8_t[]>& string_buf, uint64_t id) {
+									const simdjson::dom::parser::loaded_bytes_ptr& buf, const std::unique_ptr<uint8_t[]>& string_buf, uint64_t id,
+									::claujson::StringArena* arena = nullptr, ::claujson::KeyCache* keys = nullptr) {
 		data.clear();
 
 		uint32_t string_length;
@@ -445,26 +1076,38 @@ namespace simdjson {
 				data.is_key = true;
 			}
 
+			// idx2 is after the closing quote, unescaping does not make a string longer.
+			const bool intern = key && keys;
+			uint8_t* dest = arena && !intern ? reinterpret_cast<uint8_t*>(arena->Reserve(StringEnd(buf.get(), idx, idx2) - idx)) : &string_buf[idx];
+
 			if (auto* x = simdjson::SIMDJSON_IMPLEMENTATION::stringparsing::parse_string((uint8_t*)&buf[idx] + 1,
-				&string_buf[idx]); x == nullptr) {
+				dest); x == nullptr) {
 				std::cout << "ERROR in string\n";
-				// error processing?
-				exit(1);
+				data.clear();
+				return data;
 			}
 			else {
 				*x = '\0';
-				string_length = uint32_t(x - &string_buf[idx]);
+				string_length = uint32_t(x - dest);
 			}
 
 			// chk token_arr_start + i + 1 >= imple->n_structural_indexes...
-			data.set_str_val(&string_buf[idx], string_length);
+			if (intern) {
+				data.set_interned_str_val(keys->Intern(reinterpret_cast<char*>(dest), string_length));
+			}
+			else if (arena) {
+				data.set_arena_str_val(arena->Commit(reinterpret_cast<char*>(dest), string_length));
+			}
+			else {
+				data.set_str_val(dest, string_length);
+			}
 
 		}
 		break;
 		case 't':
 		{
 			if (!simdjson::SIMDJSON_IMPLEMENTATION::atomparsing::is_valid_true_atom(reinterpret_cast<uint8_t*>(&buf[idx]), idx2 - idx)) {
-				exit(1);
+				return data;
 			}
 
 			data.type = (simdjson::internal::tape_type)buf[idx];
@@ -472,14 +1115,14 @@ namespace simdjson {
 		break;
 		case 'f':
 			if (!simdjson::SIMDJSON_IMPLEMENTATION::atomparsing::is_valid_false_atom(reinterpret_cast<uint8_t*>(&buf[idx]), idx2 - idx)) {
-				exit(1);
+				return data;
 			}
 
 			data.type = (simdjson::internal::tape_type)buf[idx];
 			break;
 		case 'n':
 			if (!simdjson::SIMDJSON_IMPLEMENTATION::atomparsing::is_valid_null_atom(reinterpret_cast<uint8_t*>(&buf[idx]), idx2 - idx)) {
-				exit(1);
+				return data;
 			}
 
 			data.type = (simdjson::internal::tape_type)buf[idx];
@@ -489,24 +1132,31 @@ namespace simdjson {
 		case '1': case '2': case '3': case '4':
 		case '5': case '6': case '7': case '8': case '9':
 		{
+			uint8_t* value = reinterpret_cast<uint8_t*>(buf.get() + idx);
+
 			std::unique_ptr<uint8_t[]> copy;
+			uint8_t small_copy[64 + SIMDJSON_PADDING];
 
 			uint64_t temp[2];
 			SIMDJSON_IMPLEMENTATION::Writer writer{ temp };
-			uint8_t* value = reinterpret_cast<uint8_t*>(buf.get() + idx);
-			
-			if (id == 0) {
-				copy = std::unique_ptr<uint8_t[]>(new (std::nothrow) uint8_t[idx2 - idx + SIMDJSON_PADDING]);
-				if (copy.get() == nullptr) { exit(3); }
-				std::memcpy(copy.get(), &buf[idx], idx2 - idx);
-				std::memset(copy.get() + idx2 - idx, ' ', SIMDJSON_PADDING);
-				value = copy.get();
+
+			if (id == 0) { // the end of the input can follow, a copy ends with spaces.
+				if (idx2 - idx <= 64) {
+					value = small_copy;
+				}
+				else {
+					copy = std::unique_ptr<uint8_t[]>(new (std::nothrow) uint8_t[idx2 - idx + SIMDJSON_PADDING]);
+					if (copy.get() == nullptr) { return data; }
+					value = copy.get();
+				}
+				std::memcpy(value, &buf[idx], idx2 - idx);
+				std::memset(value + idx2 - idx, ' ', SIMDJSON_PADDING);
 			}
 
 			if (auto x = SIMDJSON_IMPLEMENTATION::numberparsing::parse_number<SIMDJSON_IMPLEMENTATION::Writer>(value, writer)
 					; x != simdjson::error_code::SUCCESS) {
 				std::cout << "parse number error. " << x << "\n";
-				exit(1);
+				return data;
 			}
 
 			data.type = static_cast<simdjson::internal::tape_type>(temp[0] >> 56);
@@ -548,7 +1198,7 @@ namespace simdjson {
 		}
 		default:
 			std::cout << "convert error " << buf[idx] << "\n";
-			exit(1);
+			return data;
 		}
 		return data;
 	}
@@ -597,9 +1247,259 @@ namespace claujson {
 		}
 	};
 
-	class UserType {
-		friend UserType* ChkPool(UserType*& node, PoolManager& manager);
-	
+	// input kept for lazy nodes ( Parser::set_lazy(true) ), keys and values are converted on first access.
+	class LazyInput {
+	public:
+		const simdjson::dom::parser::loaded_bytes_ptr* buf = nullptr;
+		const std::unique_ptr<uint8_t[]>* string_buf = nullptr;
+		uint64_t first_idx = 0; // the first token, Convert`s id == 0.
+
+		// for unexpanded containers ( Parser::set_lazy_subtrees(true) ), see UserType::Expand.
+		const uint32_t* structural_indexes = nullptr;
+		const uint32_t* match = nullptr; // bracket index.
+		PoolManager* manager = nullptr; // nodes of expanded children.
+		size_t index_threshold = 0; // objects with this many children or more -> auto_index, when expanded.
+	private:
+		static const size_t LOCK_NUM = 64;
+		std::mutex locks[LOCK_NUM];
+		StringArena arenas[LOCK_NUM]; // strings converted under locks[i].
+		KeyCache key_caches[LOCK_NUM]; // keys interned under locks[i].
+
+		static size_t get_stripe(const void* node) {
+			return (reinterpret_cast<uintptr_t>(node) / 64) % LOCK_NUM;
+		}
+	public:
+		std::mutex& get_lock(const void* node) {
+			return locks[get_stripe(node)];
+		}
+
+		// use with get_lock(node) locked.
+		StringArena& get_arena(const void* node) {
+			return arenas[get_stripe(node)];
+		}
+
+		// use with get_lock(node) locked, nullptr : keys are not interned.
+		KeyCache* get_key_cache(const void* node) {
+			KeyCache& x = key_caches[get_stripe(node)];
+			return x.get_table() ? &x : nullptr;
+		}
+
+		void SetKeyTable(KeyTable* key_table) {
+			for (auto& x : key_caches) {
+				x = KeyCache(key_table);
+			}
+		}
+
+		// strings of converted nodes -> manager.
+		void ReleaseArenas(PoolManager& manager) {
+			for (auto& x : arenas) {
+				if (x.get_block_num() > 0) {
+					manager.AddArena(std::move(x));
+				}
+			}
+		}
+
+		void ClearArenas() {
+			for (auto& x : arenas) {
+				x.Clear();
+			}
+		}
+
+		// strings of converted nodes, not released yet.
+		void AddMemoryUsage(MemoryUsage& usage) {
+			for (size_t i = 0; i < LOCK_NUM; ++i) {
+				std::lock_guard<std::mutex> guard(locks[i]);
+				usage.AddArena(arenas[i]);
+			}
+		}
+	};
+
+	// key for find_ut, with the KeyTable of the document -> interned keys are compared by pointer.
+	class Key {
+	public:
+		std::string_view str;
+		const KeyTable* table = nullptr;
+		const char* sym = nullptr; // str in table, nullptr : not found, no interned key is str.
+	public:
+		Key(std::string_view str, const KeyTable* table = nullptr)
+			: str(str), table(table), sym(table ? table->Find(str) : nullptr) {
+			//
+		}
+	};
+
+	// children of a container, contiguous. 16 bytes.
+	// capacity == 0 : in an arena ( sealed, exact size ) or empty, capacity > 0 : malloc-ed.
+	// elements of a sealed list can be changed in place, it is copied to the heap when it grows.
+	class ChildList {
+	private:
+		UserType** arr = nullptr;
+		uint32_t count = 0;
+		uint32_t capacity = 0;
+	public:
+		ChildList() { }
+
+		ChildList(const ChildList& other) {
+			if (other.count > 0) {
+				Grow(other.count);
+				std::memcpy(arr, other.arr, other.count * sizeof(UserType*));
+				count = other.count;
+			}
+		}
+
+		ChildList(ChildList&& other) noexcept {
+			std::swap(arr, other.arr);
+			std::swap(count, other.count);
+			std::swap(capacity, other.capacity);
+		}
+
+		ChildList& operator=(const ChildList& other) {
+			if (this != &other) {
+				ChildList temp(other);
+				std::swap(arr, temp.arr);
+				std::swap(count, temp.count);
+				std::swap(capacity, temp.capacity);
+			}
+			return *this;
+		}
+
+		ChildList& operator=(ChildList&& other) noexcept {
+			if (this != &other) {
+				ChildList temp(std::move(other));
+				std::swap(arr, temp.arr);
+				std::swap(count, temp.count);
+				std::swap(capacity, temp.capacity);
+			}
+			return *this;
+		}
+
+		~ChildList() {
+			if (capacity > 0) {
+				free(arr);
+			}
+		}
+
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		bool is_sealed() const { return capacity == 0 && arr; }
+		size_t get_heap_size() const { return capacity * sizeof(UserType*); } // 0 : in an arena or empty.
+
+		UserType*& operator[](size_t idx) { return arr[idx]; }
+		UserType* const& operator[](size_t idx) const { return arr[idx]; }
+
+		UserType*& back() { return arr[count - 1]; }
+		UserType* const& back() const { return arr[count - 1]; }
+
+		UserType** begin() { return arr; }
+		UserType** end() { return arr + count; }
+		UserType* const* begin() const { return arr; }
+		UserType* const* end() const { return arr + count; }
+
+		void reserve(size_t n) {
+			if (n > capacity && n > count) {
+				Grow(n);
+			}
+		}
+
+		void push_back(UserType* x) {
+			if (count >= capacity) { // full, or sealed ( capacity == 0 )
+				Grow(count < 4 ? 4 : size_t(count) * 2);
+			}
+			arr[count] = x;
+			++count;
+		}
+
+		// in place, also for a sealed list.
+		void erase(UserType* const* pos) {
+			const size_t idx = pos - arr;
+			std::memmove(arr + idx, arr + idx + 1, (count - idx - 1) * sizeof(UserType*));
+			--count;
+		}
+
+		void clear() {
+			if (capacity == 0) {
+				arr = nullptr;
+			}
+			count = 0;
+		}
+
+		// arr has n children and is in an arena ( not freed by the list ), the old children are dropped.
+		void Adopt(UserType** arr, size_t n) {
+			if (capacity > 0) {
+				free(this->arr);
+			}
+			this->arr = arr;
+			count = uint32_t(n);
+			capacity = 0;
+		}
+
+		// sealed -> heap, then the list does not need the arena.
+		void Own() {
+			if (is_sealed()) {
+				Grow(count);
+			}
+		}
+
+		// children -> arena ( exact size ), the heap buffer -> spare, spare lends it to the next container.
+		void Seal(StringArena& arena, ChildList& spare) {
+			UserType** x = nullptr;
+			if (count > 0) {
+				x = (UserType**)arena.Alloc(count * sizeof(UserType*));
+				std::memcpy(x, arr, count * sizeof(UserType*));
+			}
+			if (capacity > 0) {
+				std::swap(arr, spare.arr);
+				std::swap(capacity, spare.capacity);
+				spare.count = 0;
+				if (capacity > 0) {
+					free(arr);
+				}
+			}
+			arr = x;
+			capacity = 0;
+		}
+	private:
+		void Grow(size_t n) {
+			UserType** x = (UserType**)malloc(n * sizeof(UserType*));
+			if (!x) {
+				throw std::bad_alloc(); // not exit, it runs on workers of a ThreadPool.
+			}
+			if (count > 0) {
+				std::memcpy(x, arr, count * sizeof(UserType*));
+			}
+			if (capacity > 0) {
+				free(arr);
+			}
+			arr = x;
+			capacity = uint32_t(n);
+		}
+	};
+
+	// key -> child of an object, for find and find_ut on objects with many children. ( see UserType::build_index )
+	//   keys are views of the key strings of the children, the first child of a key is kept, like the linear search.
+	class KeyIndex {
+	private:
+		std::unordered_map<std::string_view, UserType*> map;
+	public:
+		inline explicit KeyIndex(const ChildList& children);
+
+		UserType* Find(std::string_view key) const {
+			auto iter = map.find(key);
+			return iter != map.end() ? iter->second : nullptr;
+		}
+
+		// child is added after the others.
+		inline void Add(UserType* child);
+		// child is removed from children. ( still in children now )
+		inline void Remove(const UserType* child, const ChildList& children);
+
+		// the nodes of the map are estimated.
+		size_t get_bytes() const {
+			return sizeof(KeyIndex) + map.bucket_count() * sizeof(void*) + map.size() * (sizeof(std::string_view) + 3 * sizeof(void*));
+		}
+	};
+
+	class UserType {
+	
 
 	private:
 		static inline UserType* make_user_type(UserType* pool, int type) {
@@ -616,9 +1516,15 @@ namespace claujson {
 
 
 		static inline UserType* make_user_type(UserType* pool, int64_t idx, int64_t idx2, int64_t len, bool key,
-							const std::unique_ptr<char[]>& buf, const std::unique_ptr<uint8_t[]>& string_buf, int type, uint64_t id)  {
+							const simdjson::dom::parser::loaded_bytes_ptr& buf, const std::unique_ptr<uint8_t[]>& string_buf, int type, uint64_t id, StringArena* arena, KeyCache* keys, LazyInput* lazy)  {
+			if (lazy) {
+				new (pool) UserType(ItemType(make_lazy(idx, idx2, key), Data()), type);
+				pool->alloc_type = PoolManager::Type::FROM_POOL;
+				pool->lazy.store(lazy, std::memory_order_relaxed);
+				return pool;
+			}
 			Data temp;
-			simdjson::Convert(temp, idx, idx2, len, key, buf, string_buf, id);
+			simdjson::Convert(temp, idx, idx2, len, key, buf, string_buf, id, arena, keys);
 			new (pool) UserType(ItemType(std::move(temp), Data()), type);
 			pool->alloc_type = PoolManager::Type::FROM_POOL;
 			return pool;
@@ -626,10 +1532,16 @@ namespace claujson {
 
 		// object element.
 		static inline UserType* make_item_type(UserType* pool, int64_t idx11, int64_t idx12, int64_t len1, bool key1, int64_t idx21, int64_t idx22, int64_t len2, bool key2,
-			const std::unique_ptr<char[]>& buf, const std::unique_ptr<uint8_t[]>& string_buf, uint64_t id, uint64_t id2)  {
+			const simdjson::dom::parser::loaded_bytes_ptr& buf, const std::unique_ptr<uint8_t[]>& string_buf, uint64_t id, uint64_t id2, StringArena* arena, KeyCache* keys, LazyInput* lazy)  {
+			if (lazy) {
+				new (pool) UserType(ItemType(make_lazy(idx11, idx12, key1), make_lazy(idx21, idx22, key2)), 4);
+				pool->alloc_type = PoolManager::Type::FROM_POOL;
+				pool->lazy.store(lazy, std::memory_order_relaxed);
+				return pool;
+			}
 			Data temp, temp2;
-			simdjson::Convert(temp, idx11, idx12, len1, key1, buf, string_buf, id);
-			simdjson::Convert(temp2, idx21, idx22, len2, key2, buf, string_buf, id2);
+			simdjson::Convert(temp, idx11, idx12, len1, key1, buf, string_buf, id, arena, keys);
+			simdjson::Convert(temp2, idx21, idx22, len2, key2, buf, string_buf, id2, arena, keys);
 			new (pool) UserType(ItemType(std::move(temp), std::move(temp2)), 4);
 			pool->alloc_type = PoolManager::Type::FROM_POOL;
 			return pool;
@@ -637,15 +1549,58 @@ namespace claujson {
 
 		// array element.
 		static inline UserType* make_item_type(UserType* pool, int64_t idx21, int64_t idx22, int64_t len2,
-			const std::unique_ptr<char[]>& buf,
-				const std::unique_ptr<uint8_t[]>& string_buf, uint64_t id)  {
+			const simdjson::dom::parser::loaded_bytes_ptr& buf,
+				const std::unique_ptr<uint8_t[]>& string_buf, uint64_t id, StringArena* arena, KeyCache* keys, LazyInput* lazy)  {
+			if (lazy) {
+				new (pool) UserType(ItemType(Data(), make_lazy(idx21, idx22, false)), 4);
+				pool->alloc_type = PoolManager::Type::FROM_POOL;
+				pool->lazy.store(lazy, std::memory_order_relaxed);
+				return pool;
+			}
 			Data temp, temp2;
-			simdjson::Convert(temp2, idx21, idx22, len2, false, buf, string_buf, id);
+			simdjson::Convert(temp2, idx21, idx22, len2, false, buf, string_buf, id, arena, keys);
 			new (pool) UserType(ItemType(std::move(temp), std::move(temp2)), 4);
 			pool->alloc_type = PoolManager::Type::FROM_POOL;
 			return pool;
 		}
 
+		// only offsets, uint_val = idx2 << 32 | idx ( structural indexes are 32 bits )
+		static inline Data make_lazy(int64_t idx, int64_t idx2, bool key) {
+			Data temp;
+			temp.uint_val = (uint64_t(idx2) << 32) | uint64_t(uint32_t(idx));
+			temp.is_key = key;
+			return temp;
+		}
+
+		static inline uint64_t lazy_idx(const Data& x) {
+			return x.uint_val & 0xFFFFFFFFu;
+		}
+
+		static inline uint64_t lazy_idx2(const Data& x) {
+			return x.uint_val >> 32;
+		}
+
+		// children later, by Expand. token : the opening bracket of this container.
+		void set_unexpanded(uint64_t token, LazyInput* input, StringArena* arena) {
+			value.data.uint_val = token;
+			lazy.store(input, std::memory_order_relaxed);
+			get_box(arena).unexpanded.store(true, std::memory_order_relaxed);
+		}
+
+		// the root value for Parser::set_lazy_subtrees, in pool. ( idx, match : tokens and bracket index )
+		static inline UserType* make_lazy_root(UserType* pool, const simdjson::dom::parser::loaded_bytes_ptr& buf,
+			const std::unique_ptr<uint8_t[]>& string_buf, const uint32_t* idx, const uint32_t* match, LazyInput* lazy) {
+			const char c = buf.get()[idx[0]];
+			if (c != '{' && c != '[') {
+				return make_item_type(pool, idx[0], idx[1], 0, buf, string_buf, 0, nullptr, nullptr, lazy);
+			}
+			make_user_type(pool, c == '{' ? 0 : 1);
+			if (match[0] != 1) { // not {} or []
+				pool->set_unexpanded(0, lazy, nullptr);
+			}
+			return pool;
+		}
+
 		static inline UserType* make_item_type(UserType* pool, Data&& name, Data&& data)  {
 			new (pool) UserType(ItemType(std::move(name), std::move(data)), 4);
 			pool->alloc_type = PoolManager::Type::FROM_POOL;
@@ -659,106 +1614,390 @@ namespace claujson {
 		}
 
 	public:
+		// Manager : PoolManager, or PoolManager::Cache of this thread.
 
-
-		inline static UserType* make_object(PoolManager& manager, ItemType&& x) {
+		template <class Manager>
+		inline static UserType* make_object(Manager& manager, ItemType&& x) {
 			UserType* temp = manager.Alloc();
-			new (temp) UserType(std::move(x), 0);
+			*temp = UserType(std::move(x), 0);
 			return temp;
 		}
 
-		inline static UserType* make_array(PoolManager& manager, ItemType&& x) {
+		template <class Manager>
+		inline static UserType* make_array(Manager& manager, ItemType&& x) {
 			UserType* temp = manager.Alloc();
-			new (temp) UserType(std::move(x), 1);
+			*temp = UserType(std::move(x), 1);
 			return temp;
 		}
 
 		void set_value(const Data& key, const Data& data) {
+			Expand(); // lazy of an unexpanded container is for its children.
+			this->lazy.store(nullptr, std::memory_order_relaxed);
 			this->value.key = key;
 			this->value.data = data;
 		}
 
 		UserType* clone() const {
+			Decode();
+			Expand();
+
 			UserType* temp = new UserType(this->value);
 
 			temp->type = this->type;
 
 			temp->parent = nullptr; // chk!
 
-			temp->data.reserve(this->data.size());
+			if (this->box) {
+				temp->make_list().reserve(this->box->data.size());
 
-			for (auto x : this->data) {
-				temp->data.push_back(x->clone());
+				for (auto x : this->box->data) {
+					temp->box->data.push_back(x->clone());
+				}
 			}
 
 			return temp;
 		}
 
 	private:
-		std::vector<UserType*> data;
+		// what only a container needs, made on first use. ( items have none, so a node is 64 bytes )
+		struct Container {
+			ChildList data;
+			std::atomic<KeyIndex*> index{ nullptr }; // of an object, see build_index.
+			bool auto_index = false; // build the index on the first find.
+			std::atomic<bool> unexpanded{ false }; // children are not made yet. ( key is converted, lazy -> input, value.data.uint_val -> its bracket token )
+			bool in_arena = false; // only destroyed, the arena frees it.
+
+			~Container() {
+				delete index.load(std::memory_order_relaxed);
+			}
+		};
 
-		UserType* next_dead = nullptr; // for linked list.
+		inline static const ChildList no_children;
 
-		friend PoolManager;
+		ItemType value; // equal to key
 
-		PoolManager::Type alloc_type;
+		friend PoolManager;
+		friend PoolManager::Cache;
+		friend KeyIndex;
 
-		uint64_t alloc_idx = 0;
+		union {
+			Container* box = nullptr; // nullptr : no children, no index, expanded.
+			UserType* next_dead; // for linked list. ( free nodes of PoolManager, not constructed or destroyed )
+		};
 
-		ItemType value; // equal to key
-		int type = -1; // 0 - object, 1 - array, 2 - virtual object, 3 - virtual array, 4 - item, -1 - root  -2 - only in parse...
+		mutable std::atomic<LazyInput*> lazy{ nullptr }; // not nullptr -> value is not converted yet.
 		UserType* parent = nullptr;
+		int type = -1; // 0 - object, 1 - array, 2 - virtual object, 3 - virtual array, 4 - item, -1 - root  -2 - only in parse...
+		PoolManager::Type alloc_type = PoolManager::Type::FROM_STATIC;
+
+		// children, without Expand.
+		const ChildList& list() const {
+			return box ? box->data : no_children;
+		}
+
+		// box is made if there is none. arena : for a node of a pool ( other nodes can outlive the arenas ), nullptr -> heap.
+		Container& get_box(StringArena* arena = nullptr) {
+			if (!box) {
+				if (arena && alloc_type == PoolManager::Type::FROM_POOL) {
+					box = new (arena->Alloc(sizeof(Container))) Container();
+					box->in_arena = true;
+				}
+				else {
+					box = new Container();
+				}
+			}
+			return *box;
+		}
+
+		ChildList& make_list(StringArena* arena = nullptr) {
+			return get_box(arena).data;
+		}
+
+		void free_box() {
+			if (box) {
+				if (box->in_arena) {
+					box->~Container();
+				}
+				else {
+					delete box;
+				}
+				box = nullptr;
+			}
+		}
+
+		// box and child list -> heap, then the node does not need the arenas.
+		void Own() {
+			if (box && box->in_arena) {
+				Container* x = new Container();
+				x->data = std::move(box->data);
+				x->index.store(box->index.exchange(nullptr));
+				x->auto_index = box->auto_index;
+				x->unexpanded.store(box->unexpanded.load());
+				box->~Container();
+				box = x;
+			}
+			if (box) {
+				box->data.Own();
+			}
+		}
+
+		bool is_unexpanded(std::memory_order order = std::memory_order_acquire) const {
+			return box && box->unexpanded.load(order);
+		}
 	public:
 		//inline const static size_t npos = -1; // ?
 		// chk type?
 		bool operator<(const UserType& other) const {
-			return *(value.key.get_str_val()) < *(other.value.key.get_str_val());
+			return get_value().key.get_str_val() < other.get_value().key.get_str_val();
 		}
 		bool operator==(const UserType& other) const {
-			return *(value.key.get_str_val()) == *(other.value.key.get_str_val());
+			return get_value().key.get_str_val() == other.get_value().key.get_str_val();
 		}
 
 	public:
 
-		inline const std::vector<UserType*>& get_data() const { return data; }
-		inline std::vector<UserType*>& get_data() { return data; }
+		inline const ChildList& get_data() const { Expand(); return list(); }
+		inline ChildList& get_data() { Expand(); return make_list(); }
+
+		// make the children of an unexpanded container, once. ( Parser::set_lazy_subtrees ) (thread safe)
+		//   get_data, get_data_list, get_data_size, find, find_ut and edits call it.
+		inline void Expand() const;
+
+		bool is_expanded() const {
+			return !is_unexpanded();
+		}
+
+		// key index of an object, find and find_ut are O(1) with it. ( opt in, ex) Parser::set_index_threshold )
+		//   kept up to date by add_object_element, add_object_with_key, add_array_with_key, remove_data_list and remove_all,
+		//   other edits ( get_data(), set_value of a child.. ) need drop_index. build_index is thread safe. ( no index for no child, see set_auto_index )
+		inline void build_index() const;
+
+		void drop_index() {
+			if (box) {
+				delete box->index.exchange(nullptr, std::memory_order_acq_rel);
+			}
+		}
+
+		bool has_index() const {
+			return box && box->index.load(std::memory_order_acquire) != nullptr;
+		}
+
+		// true : the index is built on the first find or find_ut.
+		void set_auto_index(bool auto_index) {
+			if (box || auto_index) {
+				get_box().auto_index = auto_index;
+			}
+		}
+
+		bool is_auto_index() const {
+			return box && box->auto_index;
+		}
+
+		// a child ( item or container ) with key, the first one. nullptr : not found.
+		UserType* find(std::string_view key) {
+			return const_cast<UserType*>(static_cast<const UserType*>(this)->find(key));
+		}
+
+		const UserType* find(std::string_view key) const {
+			if (const KeyIndex* x = get_index()) {
+				return x->Find(key);
+			}
+			if (!is_object()) { // children of an object have keys, is_key of a lazy child can be written by Decode now.
+				return nullptr;
+			}
+			for (size_t i = 0; i < list().size(); ++i) {
+				if (list()[i]->key_equal(key)) {
+					return list()[i];
+				}
+			}
+			return nullptr;
+		}
+
+		UserType* find(const Key& key) {
+			return const_cast<UserType*>(static_cast<const UserType*>(this)->find(key));
+		}
+
+		const UserType* find(const Key& key) const {
+			if (const KeyIndex* x = get_index()) {
+				return x->Find(key.str);
+			}
+			if (!is_object()) { // children of an object have keys, is_key of a lazy child can be written by Decode now.
+				return nullptr;
+			}
+			for (size_t i = 0; i < list().size(); ++i) {
+				if (list()[i]->key_equal(key)) {
+					return list()[i];
+				}
+			}
+			return nullptr;
+		}
 
 		// find_ut..
 		UserType* find_ut(std::string_view key) {
-			for (size_t i = 0; i < data.size(); ++i) {
-				if (data[i]->is_user_type() && data[i]->value.key.is_key && *data[i]->value.key.get_str_val() == key) {
-					return data[i];
+			return const_cast<UserType*>(static_cast<const UserType*>(this)->find_ut(key));
+		}
+
+		const UserType* find_ut(std::string_view key) const {
+			if (const KeyIndex* x = get_index()) {
+				const UserType* ut = x->Find(key);
+				if (!ut || ut->is_user_type()) {
+					return ut;
+				}
+				// the first child of key is an item, a later one can be a container.
+			}
+			if (!is_object()) {
+				return nullptr;
+			}
+			for (size_t i = 0; i < list().size(); ++i) {
+				if (list()[i]->is_user_type() && list()[i]->key_equal(key)) {
+					return list()[i];
 				}
 			}
 			return nullptr;
 		}
 
-		const UserType* find_ut(std::string_view key) const {
-			for (size_t i = 0; i < data.size(); ++i) {
-				if (data[i]->is_user_type() && data[i]->value.key.is_key && *data[i]->value.key.get_str_val() == key) {
-					return data[i];
+		// key made once, used for many find_ut. ex) Key key("geometry", parser.get_key_table());
+		UserType* find_ut(const Key& key) {
+			return const_cast<UserType*>(static_cast<const UserType*>(this)->find_ut(key));
+		}
+
+		const UserType* find_ut(const Key& key) const {
+			if (const KeyIndex* x = get_index()) {
+				const UserType* ut = x->Find(key.str);
+				if (!ut || ut->is_user_type()) {
+					return ut;
+				}
+			}
+			if (!is_object()) {
+				return nullptr;
+			}
+			for (size_t i = 0; i < list().size(); ++i) {
+				if (list()[i]->is_user_type() && list()[i]->key_equal(key)) {
+					return list()[i];
 				}
 			}
 			return nullptr;
 		}
 
+		bool key_equal(const Key& key) const {
+			if (key.table && (is_unexpanded() || !lazy.load(std::memory_order_acquire)) && value.key.is_interned()) {
+				return value.key.str_val == key.sym;
+			}
+			return key_equal(key.str);
+		}
+
+	private:
+		const KeyIndex* get_index() const {
+			Expand(); // also sets auto_index.
+			if (!box) {
+				return nullptr;
+			}
+			const KeyIndex* x = box->index.load(std::memory_order_acquire);
+			if (!x && box->auto_index && is_object()) {
+				build_index();
+				x = box->index.load(std::memory_order_acquire);
+			}
+			return x;
+		}
+	public:
+		// lazy and no escape -> compare with the input, without converting.
+		bool key_equal(std::string_view key) const {
+			// the key of an unexpanded container is converted.
+			if (LazyInput* input = is_unexpanded() ? nullptr : lazy.load(std::memory_order_acquire)) {
+				std::unique_lock<std::mutex> guard(input->get_lock(this)); // Decode can run now.
+				if (!lazy.load(std::memory_order_relaxed)) {
+					guard.unlock();
+					return get_value().key.get_str_val() == key;
+				}
+
+				const uint64_t idx = lazy_idx(value.key);
+				const uint64_t idx2 = lazy_idx2(value.key);
+				if (idx + 1 + key.size() >= idx2) {
+					return false; // too long, unescaping does not make a string longer. ( idx2 is after the closing quote )
+				}
+				const char* str = input->buf->get() + idx + 1;
+				if (!std::memchr(str, '\\', key.size())) {
+					if (str[key.size()] == '"') {
+						return std::memcmp(str, key.data(), key.size()) == 0;
+					}
+					if (str[key.size()] != '\\') {
+						return false; // longer than key.
+					}
+				}
+				guard.unlock();
+			}
+			return get_value().key.get_str_val() == key;
+		}
+
+		// convert key and value, once. (thread safe) throws if they are wrong in the input.
+		void Decode() const {
+			if (is_unexpanded()) { // key is converted, lazy is for Expand.
+				return;
+			}
+			LazyInput* input = lazy.load(std::memory_order_acquire);
+			if (!input) {
+				return;
+			}
+
+			std::lock_guard<std::mutex> guard(input->get_lock(this));
+			if (!lazy.load(std::memory_order_relaxed)) {
+				return;
+			}
+
+			ItemType& x = const_cast<ItemType&>(value);
+			Data key, data; // x is kept lazy if one is wrong.
+
+			if (x.key.is_key) {
+				const uint64_t idx = lazy_idx(x.key), idx2 = lazy_idx2(x.key);
+				simdjson::Convert(key, idx, idx2, 0, true, *input->buf, *input->string_buf, idx == input->first_idx ? 0 : 1, &input->get_arena(this), input->get_key_cache(this));
+				if (key.type != simdjson::internal::tape_type::STRING) {
+					throw "Error in a lazy key";
+				}
+			}
+			if (type == 4) {
+				const uint64_t idx = lazy_idx(x.data), idx2 = lazy_idx2(x.data);
+				simdjson::Convert(data, idx, idx2, 0, false, *input->buf, *input->string_buf, idx == input->first_idx ? 0 : 1, &input->get_arena(this), input->get_key_cache(this));
+				if (data.type == simdjson::internal::tape_type::ROOT) {
+					throw "Error in a lazy value";
+				}
+			}
+
+			if (x.key.is_key) {
+				x.key = std::move(key);
+			}
+			if (type == 4) {
+				x.data = std::move(data);
+			}
+			lazy.store(nullptr, std::memory_order_release);
+		}
+
 	public:
 		UserType(const UserType& other)
-			: value(other.value),
-			type(other.type), parent(other.parent)
+			: value((other.Decode(), other.value)),
+			parent(other.parent), type(other.type)
 		{
-			this->data.reserve(other.data.size());
-			for (auto& x : other.data) {
-				this->data.push_back(x->clone());
+			other.Expand();
+			if (other.box) {
+				Container& x = get_box();
+				x.auto_index = other.box->auto_index;
+				x.data.reserve(other.box->data.size());
+				for (auto& y : other.box->data) {
+					x.data.push_back(y->clone());
+				}
 			}
 		}
 
 
 		UserType(UserType&& other) {
+			lazy.store(other.lazy.exchange(nullptr));
 			value = std::move(other.value);
-			this->data = std::move(other.data);
+			box = other.box;
+			other.box = nullptr;
 			type = std::move(other.type);
 			parent = std::move(other.parent);
+			if (box && box->in_arena) { // not a node of a pool, can outlive the arenas.
+				Own();
+			}
 		}
 
 		UserType& operator=(const UserType& other) noexcept {
@@ -766,8 +2005,16 @@ namespace claujson {
 				return *this;
 			}
 
+			other.Decode();
+			other.Expand();
+			lazy.store(nullptr);
 			value = (other.value);
-			data = (other.data);
+			free_box();
+			if (other.box) {
+				Container& x = get_box();
+				x.data = other.box->data;
+				x.auto_index = other.box->auto_index;
+			}
 			type = (other.type);
 			parent = (other.parent);
 
@@ -779,15 +2026,21 @@ namespace claujson {
 				return *this;
 			}
 
+			lazy.store(other.lazy.exchange(nullptr));
 			value = std::move(other.value);
-			data = std::move(other.data);
+			free_box();
+			box = other.box;
+			other.box = nullptr;
 			type = std::move(other.type);
 			parent = std::move(other.parent);
+			if (box && box->in_arena && alloc_type != PoolManager::Type::FROM_POOL) { // can outlive the arenas.
+				Own();
+			}
 
 			return *this;
 		}
 
-		const ItemType& get_value() const { return value; }
+		const ItemType& get_value() const { Decode(); return value; }
 
 
 	private:
@@ -801,7 +2054,7 @@ namespace claujson {
 				exit(14);
 			}
 
-			data.push_back(ut);
+			make_list().push_back(ut);
 
 			ut->parent = this;
 		}
@@ -814,7 +2067,7 @@ namespace claujson {
 				exit(16);
 			}
 
-			this->data.push_back(item);
+			make_list().push_back(item);
 		}
 
 	private:
@@ -831,8 +2084,8 @@ namespace claujson {
 		UserType() noexcept : type(-1) {
 			//
 		}
-		virtual ~UserType() noexcept {
-			//
+		~UserType() noexcept {
+			free_box();
 		}
 	public:
 
@@ -861,47 +2114,65 @@ namespace claujson {
 		}
 
 		// name key check?
-		void add_object_element(PoolManager& manager, const claujson::Data& name, const claujson::Data& data) {
+		template <class Manager>
+		void add_object_element(Manager& manager, const claujson::Data& name, const claujson::Data& data) {
 			// todo - chk this->type == 0 (object) but name is empty
 			// todo - chk this->type == 1 (array) but name is not empty.
 
 			if (this->type == 1) {
 				throw "Error add object element to array in add_object_element ";
 			}
-			if (this->type == -1 && this->data.size() >= 1) {
+			Expand();
+			if (this->type == -1 && list().size() >= 1) {
 				throw "Error not valid json in add_object_element";
 			}
 
-			this->data.push_back(make_item_type(manager.Alloc(), name, data));
+			make_list().push_back(make_item_type(manager.Alloc(), name, data));
+			if (KeyIndex* x = box->index.load(std::memory_order_relaxed)) {
+				x->Add(box->data.back());
+			}
 		}
 
-		void add_array_element(PoolManager& manager, const claujson::Data& data) {
+		template <class Manager>
+		void add_array_element(Manager& manager, const claujson::Data& data) {
 			// todo - chk this->type == 0 (object) but name is empty
 			// todo - chk this->type == 1 (array) but name is not empty.
 
 			if (this->type == 0) {
 				throw "Error add object element to array in add_array_element ";
 			}
-			if (this->type == -1 && this->data.size() >= 1) {
+			Expand();
+			if (this->type == -1 && list().size() >= 1) {
 				throw "Error not valid json in add_array_element";
 			}
 
-			this->data.push_back(make_item_type(manager.Alloc(), Data(), data)); // (Type*)make_item_type(std::move(temp), data));
+			make_list().push_back(make_item_type(manager.Alloc(), Data(), data)); // (Type*)make_item_type(std::move(temp), data));
 		}
 
-		void remove_all(PoolManager& manager, UserType* ut) {
-			for (size_t i = 0; i < ut->data.size(); ++i) {
-				if (ut->data[i]) {
-					manager.DeAlloc(ut);
-
-					remove_all(manager, ut->data[i]);
-					ut->data[i] = nullptr;
+		// children of ut -> manager. ( ut is kept )
+		template <class Manager>
+		void remove_all(Manager& manager, UserType* ut) {
+			if (!ut->box) {
+				return;
+			}
+			if (ut->box->unexpanded.load(std::memory_order_relaxed)) { // no children yet, they are not made.
+				ut->lazy.store(nullptr, std::memory_order_relaxed);
+				ut->box->unexpanded.store(false, std::memory_order_relaxed);
+			}
+			ChildList& data = ut->box->data;
+			for (size_t i = 0; i < data.size(); ++i) {
+				if (data[i]) {
+					remove_all(manager, data[i]);
+					manager.DeAlloc(data[i]);
+					data[i] = nullptr;
 				}
 			}
-			ut->data.clear();
+			data.clear();
+			ut->drop_index();
 		}
 
-		void remove_all(PoolManager& manager) {
+		template <class Manager>
+		void remove_all(Manager& manager) {
 			remove_all(manager, this);
 		}
 
@@ -909,13 +2180,8 @@ namespace claujson {
 
 		//todo..
 		void remove_all(UserType* ut) {
-			for (size_t i = 0; i < ut->data.size(); ++i) {
-				if (ut->data[i]) {
-					//remove_all(ut->data[i]);
-					ut->data[i] = nullptr;
-				}
-			}
-			ut->data.clear();
+			ut->free_box(); // the list is freed, virtual nodes are not destroyed.
+			ut->lazy.store(nullptr);
 			ut->value = ItemType();
 		}
 
@@ -931,12 +2197,16 @@ namespace claujson {
 				throw "Error in add_object_with_key";
 			}
 
-			if (this->type == -1 && this->data.size() >= 1) {
+			if (this->type == -1 && list().size() >= 1) {
 				throw "Error not valid json in add_object_with_key";
 			}
+			Expand();
 
-			this->data.push_back(object);
-			((UserType*)this->data.back())->parent = this;
+			make_list().push_back(object);
+			object->parent = this;
+			if (KeyIndex* x = box->index.load(std::memory_order_relaxed)) {
+				x->Add(object);
+			}
 		}
 
 		void add_array_with_key(UserType* _array) {
@@ -946,12 +2216,16 @@ namespace claujson {
 				throw "Error in add_array_with_key";
 			}
 
-			if (this->type == -1 && this->data.size() >= 1) {
+			if (this->type == -1 && list().size() >= 1) {
 				throw "Error not valid json in add_array_with_key";
 			}
+			Expand();
 
-			this->data.push_back(_array);
-			((UserType*)this->data.back())->parent = this;
+			make_list().push_back(_array);
+			_array->parent = this;
+			if (KeyIndex* x = box->index.load(std::memory_order_relaxed)) {
+				x->Add(_array);
+			}
 		}
 
 		void add_object_with_no_key(UserType* object) {
@@ -961,12 +2235,13 @@ namespace claujson {
 				throw "Error in add_object_with_no_key";
 			}
 
-			if (this->type == -1 && this->data.size() >= 1) {
+			if (this->type == -1 && list().size() >= 1) {
 				throw "Error not valid json in add_object_with_no_key";
 			}
+			Expand();
 
-			this->data.push_back(object);
-			((UserType*)this->data.back())->parent = this;
+			make_list().push_back(object);
+			object->parent = this;
 		}
 
 		void add_array_with_no_key(UserType* _array) {
@@ -976,22 +2251,26 @@ namespace claujson {
 				throw "Error in add_array_with_no_key";
 			}
 
-			if (this->type == -1 && this->data.size() >= 1) {
+			if (this->type == -1 && list().size() >= 1) {
 				throw "Error not valid json in add_array_with_no_key";
 			}
+			Expand();
 
-			this->data.push_back(_array);
-			((UserType*)this->data.back())->parent = this;
+			make_list().push_back(_array);
+			_array->parent = this;
 		}
 
 		void reserve_data_list(size_t len) {
-			data.reserve(len);
+			Expand();
+			if (len > 0) {
+				make_list().reserve(len);
+			}
 		}
 
 	private:
 
 		inline void add_user_type(UserType* ut) {
-			this->data.push_back(ut);
+			make_list().push_back(ut);
 			ut->parent = this;
 		}
 
@@ -1021,8 +2300,8 @@ namespace claujson {
 			return ut;
 		}
 
-		inline void add_user_type(UserType* pool, int64_t idx, int64_t idx2, int64_t len, const std::unique_ptr<char[]>& buf,
-					const std::unique_ptr<uint8_t[]>& string_buf, int type, uint64_t id) {
+		inline void add_user_type(UserType* pool, int64_t idx, int64_t idx2, int64_t len, const simdjson::dom::parser::loaded_bytes_ptr& buf,
+					const std::unique_ptr<uint8_t[]>& string_buf, int type, uint64_t id, StringArena* arena, KeyCache* keys, LazyInput* lazy) {
 			// todo - chk this->type == 0 (object) but name is empty
 			// todo - chk this->type == 1 (array) but name is not empty.
 			// todo - chk this->type == -1 .. one object or one array or data(true or false or null or string or number).
@@ -1037,9 +2316,9 @@ namespace claujson {
 			//	throw "Error not valid json in add_user_type";
 			//}
 
-			this->data.push_back(make_user_type(pool, idx, idx2, len, true, buf, string_buf, type, id));
+			make_list().push_back(make_user_type(pool, idx, idx2, len, true, buf, string_buf, type, id, arena, keys, lazy));
 
-			((UserType*)this->data.back())->parent = this;
+			((UserType*)box->data.back())->parent = this;
 		}
 
 		inline void add_user_type(UserType* pool, int type) {
@@ -1056,15 +2335,15 @@ namespace claujson {
 			//	throw "Error not valid json in add_user_type";
 			//}
 
-			this->data.push_back(make_user_type(pool, type));
+			make_list().push_back(make_user_type(pool, type));
 
-			((UserType*)this->data.back())->parent = this;
+			((UserType*)box->data.back())->parent = this;
 
 		}
 
 		// add item_type in object? key = value
 		inline void add_item_type(UserType* pool, int64_t idx11, int64_t idx12, int64_t len1, int64_t idx21, int64_t idx22, int64_t len2,
-			const std::unique_ptr<char[]>& buf, const std::unique_ptr<uint8_t[]>& string_buf, uint64_t id, uint64_t id2) {
+			const simdjson::dom::parser::loaded_bytes_ptr& buf, const std::unique_ptr<uint8_t[]>& string_buf, uint64_t id, uint64_t id2, StringArena* arena, KeyCache* keys, LazyInput* lazy) {
 			// todo - chk this->type == 0 (object) but name is empty
 			// todo - chk this->type == 1 (array) but name is not empty.
 
@@ -1078,12 +2357,12 @@ namespace claujson {
 			//}
 
 			{
-				this->data.push_back(make_item_type(pool, idx11, idx12, len1, true, idx21, idx22, len2, false, buf, string_buf, id, id2));
+				make_list().push_back(make_item_type(pool, idx11, idx12, len1, true, idx21, idx22, len2, false, buf, string_buf, id, id2, arena, keys, lazy));
 			}
 		}
 
 		inline void add_item_type(UserType* pool, int64_t idx21, int64_t idx22, int64_t len2, 
-					const std::unique_ptr<char[]>& buf, const std::unique_ptr<uint8_t[]>& string_buf, uint64_t id) {
+					const simdjson::dom::parser::loaded_bytes_ptr& buf, const std::unique_ptr<uint8_t[]>& string_buf, uint64_t id, StringArena* arena, KeyCache* keys, LazyInput* lazy) {
 			// todo - chk this->type == 0 (object) but name is empty
 			// todo - chk this->type == 1 (array) but name is not empty.
 
@@ -1097,7 +2376,7 @@ namespace claujson {
 			//	throw "Error not valid json in add_item_type";
 			//}
 
-			this->data.push_back(make_item_type(pool, idx21, idx22, len2, buf, string_buf, id));
+			make_list().push_back(make_item_type(pool, idx21, idx22, len2, buf, string_buf, id, arena, keys, lazy));
 		}
 
 		inline void add_item_type(UserType* pool, const Data& name, const claujson::Data& data) {
@@ -1113,7 +2392,7 @@ namespace claujson {
 			//	throw "Error not valid json in add_item_type";
 		//	}
 
-			this->data.push_back(make_item_type(pool, name, data));
+			make_list().push_back(make_item_type(pool, name, data));
 		}
 
 		inline void add_item_type(UserType* pool, const claujson::Data& data) {
@@ -1128,24 +2407,34 @@ namespace claujson {
 				exit(1);
 			}
 
-			this->data.push_back(make_item_type(pool, Data(), data));
+			make_list().push_back(make_item_type(pool, Data(), data));
 		}
 
 	public:
 
 		UserType*& get_data_list(size_t idx) {
-			return this->data[idx];
+			Expand();
+			return box->data[idx];
 		}
 		const UserType* const& get_data_list(size_t idx) const {
-			return this->data[idx];
+			Expand();
+			return box->data[idx];
 		}
 
 		size_t get_data_size() const {
-			return this->data.size();
+			Expand();
+			return list().size();
 		}
 
 
-		void remove_data_list(PoolManager& manager, size_t idx) {
+		template <class Manager>
+		void remove_data_list(Manager& manager, size_t idx) {
+			Expand();
+			ChildList& data = box->data;
+			if (KeyIndex* x = box->index.load(std::memory_order_relaxed)) {
+				x->Remove(data[idx], data);
+			}
+			remove_all(manager, data[idx]);
 			manager.DeAlloc(data[idx]);
 			data.erase(data.begin() + idx);
 		}
@@ -1160,1093 +2449,3916 @@ namespace claujson {
 		}
 
 		friend class LoadData;
+		friend class Parser;
 	};
 
-
-	inline void PoolManager::Clear() {
-		if (pool) {
-			free(pool); //
+	inline void UserType::build_index() const {
+		Expand();
+		if (!box || box->index.load(std::memory_order_acquire)) {
+			return;
 		}
-		pool = nullptr;
-		blocks.clear();
-		dead_list_start = nullptr;
-		for (size_t i = 0; i < outOfPool.size(); ++i) {
-			delete outOfPool[i];
+		KeyIndex* x = new KeyIndex(box->data);
+		KeyIndex* expected = nullptr;
+		if (!box->index.compare_exchange_strong(expected, x, std::memory_order_acq_rel)) {
+			delete x; // built by another thread.
 		}
-		outOfPool.clear();
 	}
 
-	inline UserType* PoolManager::Alloc() {
-		// 1. find space for dead_list.
-		if (dead_list_start) {
-			UserType* x = dead_list_start;
-			dead_list_start = dead_list_start->next_dead;
-
-			new (x) UserType();
-			x->alloc_type = PoolManager::Type::FROM_POOL;
-			return x;
+	// children from the tokens between the brackets, subtrees are skipped with the bracket index.
+	//   a child container is unexpanded ( {} and [] are not ), a child item is lazy.
+	inline void UserType::Expand() const {
+		if (!is_unexpanded()) {
+			return;
 		}
 
-		// 2. find space for blocks.
-		for (uint64_t i = 0; i < blocks.size(); ++i) {
-			if (blocks[i].size > 0) {
-				UserType* x = pool + blocks[i].start;
+		LazyInput* input = lazy.load(std::memory_order_acquire);
+		if (!input) { // expanded now.
+			return;
+		}
+		std::lock_guard<std::mutex> guard(input->get_lock(this));
+		if (!box->unexpanded.load(std::memory_order_relaxed)) {
+			return;
+		}
 
-				++blocks[i].start;
-				--blocks[i].size;
+		UserType* self = const_cast<UserType*>(this);
+		ChildList& data = box->data;
+		const char* str = input->buf->get();
+		const uint32_t* idx = input->structural_indexes;
+		const uint32_t* match = input->match;
+		const bool object = is_object();
+		const int64_t end = match[value.data.uint_val];
+
+		// tokens of the values, an object member is key, ':', value.
+		std::vector<int64_t> values;
+		for (int64_t i = int64_t(value.data.uint_val) + 1; i < end; ) {
+			const int64_t x = object ? i + 2 : i;
+			values.push_back(x);
+			const char c = str[idx[x]];
+			i = (c == '{' || c == '[' ? int64_t(match[x]) : x) + 2; // after ','
+		}
 
-				new (x) UserType();
-				x->alloc_type = PoolManager::Type::FROM_POOL;
-				return x;
+		std::vector<UserType*> nodes(values.size());
+		input->manager->Alloc(nodes.data(), (int64_t)nodes.size());
+		StringArena* arena = &input->get_arena(this);
+		KeyCache* keys = input->get_key_cache(this);
+
+		data.reserve(values.size());
+		for (size_t i = 0; i < values.size(); ++i) {
+			const int64_t x = values[i];
+			const char c = str[idx[x]];
+			UserType* child = nodes[i];
+
+			if (c == '{' || c == '[') {
+				Data key;
+				if (object) {
+					simdjson::Convert(key, idx[x - 2], idx[x - 1], 0, true, *input->buf, *input->string_buf, 1, arena, keys);
+					if (key.type != simdjson::internal::tape_type::STRING) { // still unexpanded.
+						data.clear();
+						for (UserType* y : nodes) {
+							input->manager->DeAlloc(y);
+						}
+						throw "Error in a lazy key";
+					}
+				}
+				make_user_type(child, std::move(key), c == '{' ? 0 : 1);
+				if (match[x] != x + 1) { // not {} or []
+					child->set_unexpanded(uint64_t(x), input, arena);
+				}
 			}
+			else if (object) {
+				make_item_type(child, idx[x - 2], idx[x - 1], 0, true, idx[x], idx[x + 1], 0, false, *input->buf, *input->string_buf, 1, 1, arena, keys, input);
+			}
+			else {
+				make_item_type(child, idx[x], idx[x + 1], 0, *input->buf, *input->string_buf, 1, arena, keys, input);
+			}
+			child->parent = self;
+			data.push_back(child);
 		}
 
-		// 3. new in out of pool. (new)
-		outOfPool.push_back(new UserType());
-		outOfPool.back()->alloc_type = PoolManager::Type::FROM_NEW;
-		outOfPool.back()->alloc_idx = outOfPool.size() - 1;
-		return outOfPool.back();
+		if (object && input->index_threshold > 0 && values.size() >= input->index_threshold) {
+			box->auto_index = true;
+		}
+		// unexpanded first, Decode and key_equal check lazy again under the lock.
+		box->unexpanded.store(false, std::memory_order_release);
+		lazy.store(nullptr, std::memory_order_release);
 	}
 
-	inline void PoolManager::DeAlloc(UserType* ut) {
-		// 1-1. from pool?
-		if (ut->alloc_type == PoolManager::Type::FROM_POOL) {
-			// 2. add dead_list..
-			ut->next_dead = this->dead_list_start;
-			this->dead_list_start = ut->next_dead;
-		}
-		// 1-2. from_outOfPool?
-		else if (ut->alloc_type == PoolManager::Type::FROM_NEW) {
-			// swap and pop_back..
-			this->outOfPool.back()->alloc_idx = ut->alloc_idx;
-			std::swap(this->outOfPool[ut->alloc_idx], this->outOfPool.back());
-			this->outOfPool.pop_back();
-		}
-		else { // STATIC
-			// nothing.
+	inline KeyIndex::KeyIndex(const ChildList& children) {
+		map.reserve(children.size());
+		for (UserType* x : children) {
+			const Data& key = x->get_value().key; // lazy -> decoded.
+			if (key.is_key) {
+				map.emplace(key.get_str_val(), x);
+			}
 		}
 	}
-}
-
-
-namespace claujson {
-	class LoadData
-	{
-	public:
 
-		static int Merge(class UserType* next, class UserType* ut, class UserType** ut_next)
-		{
+	inline void KeyIndex::Add(UserType* child) {
+		const Data& key = child->get_value().key;
+		if (key.is_key) {
+			map.emplace(key.get_str_val(), child);
+		}
+	}
 
-			// check!!
-			while (ut->get_data_size() >= 1
-				&& (ut->get_data_list(0)->is_user_type()) && (ut->get_data_list(0))->is_virtual())
-			{
-				ut = (UserType*)ut->get_data_list(0);
+	inline void KeyIndex::Remove(const UserType* child, const ChildList& children) {
+		const Data& key = child->get_value().key;
+		auto iter = map.find(key.get_str_val());
+		if (iter == map.end() || iter->second != child) {
+			return;
+		}
+		map.erase(iter);
+		for (UserType* x : children) { // the next child with the same key.
+			if (x != child && x->get_value().key.is_key && x->key_equal(key.get_str_val())) {
+				map.emplace(x->get_value().key.get_str_val(), x);
+				return;
 			}
+		}
+	}
 
-			bool chk_ut_next = false;
-
-			while (true) {
-
-				class UserType* _ut = ut;
-				class UserType* _next = next;
-
-				if (_next->is_array() && _ut->is_object()) {
-					exit(11);
-				}
-				if (_next->is_object() && _ut->is_array()) {
-					exit(12);
-				}
-
-
-				if (ut_next && _ut == *ut_next) {
-					*ut_next = _next;
-					chk_ut_next = true;
-				}
+	// RFC 6901 JSON Pointer, compiled once, used for many documents or many elements of an array.
+	//   ex) JsonPointer pointer("/features/0/geometry/coordinates"); pointer.Get(&ut)
+	//   segments are unescaped ( ~1 -> /, ~0 -> ~ ) and array indices are parsed once,
+	//   keys are looked up in table once, then interned keys are compared by pointer, like Key.
+	//   table : the KeyTable of the documents it is used with, nullptr : keys are compared as strings.
+	class JsonPointer {
+	private:
+		struct Segment {
+			std::string key;
+			const char* sym = nullptr; // key in table.
+			int64_t index = -1; // array index, -1 : not an index. ( "-" too, the element after the last )
+		};
 
+		std::vector<Segment> segments;
+		const KeyTable* table = nullptr;
+	public:
+		JsonPointer() { } // "", the whole document.
 
+		// throws if path is not a JSON Pointer.
+		explicit JsonPointer(std::string_view path, const KeyTable* table = nullptr) : table(table) {
+			if (!path.empty() && path[0] != '/') {
+				throw "Error JSON Pointer must start with /";
+			}
 
-				size_t _size = _ut->get_data_size(); // bug fix.. _next == _ut?
-				for (size_t i = 0; i < _size; ++i) {
-					if (_ut->get_data_list(i)->is_user_type()) {
-						if (((UserType*)_ut->get_data_list(i))->is_virtual()) {
-							//_ut->get_user_type_list(i)->used();
-						}
-						else {
-							_next->LinkUserType(_ut->get_data_list(i));
-							_ut->get_data_list(i) = nullptr;
+			size_t i = 0;
+			while (i < path.size()) {
+				++i; // '/'
+				Segment segment;
+				while (i < path.size() && path[i] != '/') {
+					if (path[i] == '~') {
+						if (i + 1 >= path.size() || (path[i + 1] != '0' && path[i + 1] != '1')) {
+							throw "Error in JSON Pointer, ~ must be ~0 or ~1";
 						}
+						segment.key.push_back(path[i + 1] == '0' ? '~' : '/');
+						i += 2;
 					}
-					else { // item type.
-						_next->LinkItemType(std::move(_ut->get_data_list(i)));
+					else {
+						segment.key.push_back(path[i]);
+						++i;
 					}
 				}
+				segment.index = ParseIndex(segment.key);
+				if (table) {
+					segment.sym = table->Find(segment.key);
+				}
+				segments.push_back(std::move(segment));
+			}
+		}
 
-				_ut->remove_all();
+		size_t size() const {
+			return segments.size();
+		}
 
-				ut = ut->get_parent();
-				next = next->get_parent();
+		// the unescaped key of segment i.
+		std::string_view get_key(size_t i) const {
+			return segments[i].key;
+		}
 
+		// ut : a root ( from Parse ), or a node to start from, ex) an element of an array.
+		// nullptr : not found.
+		UserType* Get(UserType* ut) const {
+			return const_cast<UserType*>(Get(static_cast<const UserType*>(ut)));
+		}
 
-				if (next && ut) {
-					//
+		const UserType* Get(const UserType* ut) const {
+			if (ut && ut->is_root()) {
+				ut = ut->get_data_size() > 0 ? ut->get_data_list(0) : nullptr;
+			}
+			for (size_t i = 0; ut && i < segments.size(); ++i) {
+				const Segment& segment = segments[i];
+				if (ut->is_object()) {
+					Key key(segment.key);
+					key.table = table;
+					key.sym = segment.sym;
+					ut = ut->find(key);
+				}
+				else if (ut->is_array() && segment.index >= 0) {
+					ut = size_t(segment.index) < ut->get_data_size() ? ut->get_data_list(segment.index) : nullptr;
 				}
 				else {
-					// right_depth > left_depth
-					if (!next && ut) {
-						return -1;
-					}
-					else if (next && !ut) {
-						return 1;
-					}
-
-					return 0;
+					ut = nullptr;
+				}
+			}
+			return ut;
+		}
+	private:
+		// "0" or [1-9][0-9]*, -1 : not an index.
+		static int64_t ParseIndex(std::string_view str) {
+			if (str.empty() || str.size() > 18 || (str[0] == '0' && str.size() > 1)) {
+				return -1;
+			}
+			int64_t x = 0;
+			for (char c : str) {
+				if (c < '0' || c > '9') {
+					return -1;
 				}
+				x = x * 10 + (c - '0');
 			}
+			return x;
 		}
+	};
 
+	// JSONPath subset, compiled once. results are the nodes ( not copied ), in document order. ( RFC 9535 )
+	//   $  .name  ['name']  .*  [*]  ..name  ..*  [n]  [-n]  [start:end:step]
+	//   [?(@.a.b op literal)], op : == != < <= > >=, literal : number, 'string', true, false, null
+	//   [?(@.a)] : @.a exists.
+	//   ex) JsonPath("$.features[?(@.properties.BLOCK_NUM == '0001')].geometry").Evaluate(&ut, &parser.get_thread_pool())
+	// table : the KeyTable of the documents it is used with, nullptr : keys are compared as strings. ( like JsonPointer )
+	class JsonPath {
+	public:
+		static const size_t SPLIT_SIZE = 4096; // children per job, wider containers are split over threads.
 	private:
+		enum class StepType { CHILD, WILDCARD, INDEX, SLICE, FILTER, DESCENDANT, DESCENDANT_ALL };
+		enum class Op { EXISTS, EQ, NE, LT, LE, GT, GE };
 
-		struct Test {
-			int64_t idx;
-			int64_t idx2;
-			int64_t len;
-			uint64_t id;
-			bool is_key = false;
-		};
+		struct Step {
+			StepType type = StepType::CHILD;
 
-		static bool __LoadData(claujson::UserType* _pool, const std::unique_ptr<char[]>& buf, size_t buf_len,
-			const std::unique_ptr<uint8_t[]>& string_buf,
-			const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple,
-			int64_t token_arr_start, size_t token_arr_len, class UserType* _global,
-			int start_state, int last_state, class UserType** next, int* err, int no, UserType*& after_pool)
-		{
-			//int a = clock();
+			std::string key; // CHILD, DESCENDANT
+			const char* sym = nullptr; // key in table.
 
-			simdjson::dom::parser test;
+			int64_t index = 0; // INDEX, < 0 : from the end.
 
+			int64_t start = 0, end = 0, step = 1; // SLICE
+			bool has_start = false, has_end = false;
 
-			UserType* pool = _pool + token_arr_start;
+			JsonPointer path; // FILTER, from @.
+			Op op = Op::EXISTS;
+			Data literal;
+		};
 
-			std::vector<Test> Vec;
+		// nodes[first, last), or children [begin, end) of nodes[first] if split.
+		struct Job {
+			size_t first = 0, last = 0;
+			size_t begin = 0, end = 0;
+			bool split = false;
+		};
 
-			if (token_arr_len <= 0) {
-				*next = nullptr;
-				return false;
+		std::vector<Step> steps;
+		const KeyTable* table = nullptr;
+	public:
+		// throws if path is not in the subset.
+		explicit JsonPath(std::string_view path, const KeyTable* table = nullptr) : table(table) {
+			size_t i = 0;
+			SkipSpace(path, i);
+			if (i >= path.size() || path[i] != '$') {
+				throw "Error JSONPath must start with $";
 			}
+			++i;
+
+			while (SkipSpace(path, i), i < path.size()) {
+				if (path[i] == '.') {
+					++i;
+					const bool descendant = i < path.size() && path[i] == '.';
+					if (descendant) {
+						++i;
+					}
 
-			class UserType& global = *_global;
-
-			int state = start_state;
-			size_t braceNum = 0;
-			std::vector< class UserType* > nestedUT(1);
+					if (i < path.size() && path[i] == '*') {
+						++i;
+						steps.push_back(MakeStep(descendant ? StepType::DESCENDANT_ALL : StepType::WILDCARD));
+					}
+					else if (descendant && i < path.size() && path[i] == '[') { // ..['name'], ..[*]
+						Step step = ParseBracket(path, i);
+						if (step.type == StepType::CHILD) {
+							step.type = StepType::DESCENDANT;
+						}
+						else if (step.type == StepType::WILDCARD) {
+							step.type = StepType::DESCENDANT_ALL;
+						}
+						else {
+							throw "Error in JSONPath, ..[ ] takes a name or *";
+						}
+						steps.push_back(std::move(step));
+					}
+					else {
+						std::string name = ParseName(path, i);
+						if (name.empty()) {
+							throw "Error in JSONPath, no name after .";
+						}
+						steps.push_back(MakeKeyStep(descendant ? StepType::DESCENDANT : StepType::CHILD, std::move(name)));
+					}
+				}
+				else if (path[i] == '[') {
+					steps.push_back(ParseBracket(path, i));
+				}
+				else {
+					throw "Error in JSONPath, . or [ is expected";
+				}
+			}
+		}
 
-			nestedUT.reserve(10);
-			nestedUT[0] = &global;
+		// ut : a root ( from Parse ), or a node to start from. ( $ )
+		// thread_pool - nullptr : on this thread, else wide containers and many nodes are split over thr_num workers.
+		//   ( do not call it from a worker of thread_pool )
+		std::vector<const UserType*> Evaluate(const UserType* ut, ThreadPool* thread_pool = nullptr, int thr_num = 0) const {
+			std::vector<const UserType*> now;
+			if (ut && ut->is_root()) {
+				ut = ut->get_data_size() > 0 ? ut->get_data_list(0) : nullptr;
+			}
+			if (!ut) {
+				return now;
+			}
 
-			int64_t count = 0;
+			now.push_back(ut);
+			for (const Step& step : steps) {
+				now = Apply(step, now, thread_pool, thr_num);
+				if (now.empty()) {
+					break;
+				}
+			}
+			return now;
+		}
 
-			Test key; bool is_before_comma = false;
-			bool is_now_comma = false;
+		std::vector<UserType*> Evaluate(UserType* ut, ThreadPool* thread_pool = nullptr, int thr_num = 0) const {
+			std::vector<const UserType*> x = Evaluate(static_cast<const UserType*>(ut), thread_pool, thr_num);
+			std::vector<UserType*> result(x.size());
+			for (size_t i = 0; i < x.size(); ++i) {
+				result[i] = const_cast<UserType*>(x[i]);
+			}
+			return result;
+		}
+	private:
+		static bool IsSplit(const Step& step) {
+			return step.type == StepType::WILDCARD || step.type == StepType::FILTER ||
+				step.type == StepType::DESCENDANT || step.type == StepType::DESCENDANT_ALL;
+		}
 
-			for (int64_t i = 0; i < token_arr_len; ++i) {
+		std::vector<const UserType*> Apply(const Step& step, const std::vector<const UserType*>& nodes, ThreadPool* thread_pool, int thr_num) const {
+			std::vector<const UserType*> out;
+			std::vector<const UserType*> deep; // DESCENDANT, after the children of a node.
 
-				const simdjson::internal::tape_type type = (simdjson::internal::tape_type)buf[imple->structural_indexes[token_arr_start + i]];
-				
+			const bool split = IsSplit(step);
 
-				switch (state)
-				{
-				case 0:
-				{
-					if (is_before_comma && type == simdjson::internal::tape_type::COMMA) {
-						std::cout << "before is comma\n";
-						exit(1);
-						//
-					}
-					if (!is_now_comma && type == simdjson::internal::tape_type::COMMA) {
-						std::cout << "now is not comma\n";
-						exit(1);
-						//
-					}
+			if (!thread_pool) {
+				for (const UserType* x : nodes) {
+					Run(step, x, 0, x->get_data_size(), out, deep);
+					out.insert(out.end(), deep.begin(), deep.end());
+					deep.clear();
+				}
+				return out;
+			}
 
-					if (type == simdjson::internal::tape_type::COMMA) {
-						is_before_comma = true;
-					}
-					else {
-						is_before_comma = false;
+			// small nodes are put together, up to SPLIT_SIZE children per job.
+			std::vector<Job> jobs;
+			size_t work = 0;
+			size_t job_work = 0;
+			for (size_t i = 0; i < nodes.size(); ++i) {
+				const size_t n = nodes[i]->get_data_size();
+				if (split && n > SPLIT_SIZE) {
+					for (size_t begin = 0; begin < n; begin += SPLIT_SIZE) {
+						jobs.push_back(Job{ i, i + 1, begin, std::min(n, begin + SPLIT_SIZE), true });
 					}
+					job_work = SPLIT_SIZE;
+				}
+				else if (!jobs.empty() && !jobs.back().split && job_work < SPLIT_SIZE) {
+					jobs.back().last = i + 1;
+				}
+				else {
+					jobs.push_back(Job{ i, i + 1, 0, 0, false });
+					job_work = 0;
+				}
+				const size_t w = split ? n + 1 : 1;
+				job_work += w;
+				work += w;
+			}
 
-					if (type == simdjson::internal::tape_type::COMMA) {
-						if (token_arr_start + i + 1 < imple->n_structural_indexes) {
-							const simdjson::internal::tape_type _type =
-								(simdjson::internal::tape_type)buf[imple->structural_indexes[token_arr_start + i + 1]];
+			if (jobs.size() < 2 || work < SPLIT_SIZE) {
+				return Apply(step, nodes, nullptr, 0);
+			}
 
-							if (_type == simdjson::internal::tape_type::END_ARRAY || _type == simdjson::internal::tape_type::END_OBJECT) {
-								exit(1);
-								//
-							}
+			std::vector<std::vector<const UserType*>> outs(jobs.size());
+			std::vector<std::vector<const UserType*>> deeps(jobs.size());
 
-							continue;
-						}
-						else {
-							exit(1);
-						}
+			thread_pool->ParallelFor((int64_t)jobs.size(), thr_num, [&](int64_t i) {
+				const Job& job = jobs[i];
+				if (job.split) {
+					Run(step, nodes[job.first], job.begin, job.end, outs[i], deeps[i]);
+					return;
+				}
+				std::vector<const UserType*> temp;
+				for (size_t j = job.first; j < job.last; ++j) {
+					Run(step, nodes[j], 0, nodes[j]->get_data_size(), outs[i], temp);
+					outs[i].insert(outs[i].end(), temp.begin(), temp.end());
+					temp.clear();
+				}
+			});
+
+			// the split jobs of a node : all children, then all descendants.
+			for (size_t i = 0; i < jobs.size();) {
+				size_t j = i + 1;
+				if (jobs[i].split) {
+					while (j < jobs.size() && jobs[j].split && jobs[j].first == jobs[i].first) {
+						++j;
 					}
+				}
+				for (size_t k = i; k < j; ++k) {
+					out.insert(out.end(), outs[k].begin(), outs[k].end());
+				}
+				for (size_t k = i; k < j; ++k) {
+					out.insert(out.end(), deeps[k].begin(), deeps[k].end());
+				}
+				i = j;
+			}
+			return out;
+		}
 
-					if (type == simdjson::internal::tape_type::COLON) {
-						exit(1);
-						//
+		// step on children [begin, end) of ut -> out, ( descendants of them -> deep )
+		void Run(const Step& step, const UserType* ut, size_t begin, size_t end,
+			std::vector<const UserType*>& out, std::vector<const UserType*>& deep) const {
+			switch (step.type) {
+			case StepType::CHILD:
+				if (ut->is_object()) {
+					if (const UserType* x = ut->find(MakeKey(step))) {
+						out.push_back(x);
 					}
-
-					if (token_arr_start + i + 1 < imple->n_structural_indexes) {
-						const simdjson::internal::tape_type _type = // next_type
-							(simdjson::internal::tape_type)buf[imple->structural_indexes[token_arr_start + i + 1]];
-
-						if (_type == simdjson::internal::tape_type::END_ARRAY || _type == simdjson::internal::tape_type::END_OBJECT) {
-							is_now_comma = false;
-						}
-						else if (type == simdjson::internal::tape_type::START_ARRAY || type == simdjson::internal::tape_type::START_OBJECT) {
-							is_now_comma = false;
-						}
-						else {
-							is_now_comma = true;
-						}
+				}
+				break;
+			case StepType::WILDCARD:
+				for (size_t i = begin; i < end; ++i) {
+					out.push_back(ut->get_data_list(i));
+				}
+				break;
+			case StepType::INDEX:
+				if (ut->is_array()) {
+					const int64_t n = (int64_t)ut->get_data_size();
+					const int64_t idx = step.index < 0 ? n + step.index : step.index;
+					if (idx >= 0 && idx < n) {
+						out.push_back(ut->get_data_list(idx));
 					}
-					else {
-						is_now_comma = false;
+				}
+				break;
+			case StepType::SLICE:
+				if (ut->is_array()) {
+					Slice(step, ut, out);
+				}
+				break;
+			case StepType::FILTER:
+				for (size_t i = begin; i < end; ++i) {
+					if (Test(step, ut->get_data_list(i))) {
+						out.push_back(ut->get_data_list(i));
 					}
+				}
+				break;
+			case StepType::DESCENDANT:
+			case StepType::DESCENDANT_ALL:
+				Match(step, ut, begin, end, out);
+				for (size_t i = begin; i < end; ++i) {
+					Descend(step, ut->get_data_list(i), deep);
+				}
+				break;
+			}
+		}
 
-					// Left 1
-					//else
-					if (type == simdjson::internal::tape_type::START_OBJECT ||
-						type == simdjson::internal::tape_type::START_ARRAY) { // object start, array start
-
-
+		void Match(const Step& step, const UserType* ut, size_t begin, size_t end, std::vector<const UserType*>& out) const {
+			if (step.type == StepType::DESCENDANT_ALL) {
+				for (size_t i = begin; i < end; ++i) {
+					out.push_back(ut->get_data_list(i));
+				}
+			}
+			else if (ut->is_object()) {
+				const Key key = MakeKey(step);
+				for (size_t i = begin; i < end; ++i) {
+					if (ut->get_data_list(i)->key_equal(key)) {
+						out.push_back(ut->get_data_list(i));
+					}
+				}
+			}
+		}
 
-						if (!Vec.empty()) {
+		// children of ut that match, then the same for each child. ( a node before its descendants )
+		void Descend(const Step& step, const UserType* ut, std::vector<const UserType*>& out) const {
+			const size_t n = ut->get_data_size();
+			Match(step, ut, 0, n, out);
+			for (size_t i = 0; i < n; ++i) {
+				Descend(step, ut->get_data_list(i), out);
+			}
+		}
 
-							if (Vec[0].is_key) {
-								nestedUT[braceNum]->reserve_data_list(nestedUT[braceNum]->get_data_size() + Vec.size() / 2);
+		static void Slice(const Step& step, const UserType* ut, std::vector<const UserType*>& out) {
+			const int64_t n = (int64_t)ut->get_data_size();
+			auto normalize = [n](int64_t x) { return x >= 0 ? x : n + x; };
 
-								if (Vec.size() % 2 == 1) {
-									exit(1);
-								}
+			if (step.step > 0) {
+				const int64_t lower = std::min(std::max(step.has_start ? normalize(step.start) : 0, int64_t(0)), n);
+				const int64_t upper = std::min(std::max(step.has_end ? normalize(step.end) : n, int64_t(0)), n);
+				for (int64_t i = lower; i < upper; i += step.step) {
+					out.push_back(ut->get_data_list(i));
+				}
+			}
+			else if (step.step < 0) {
+				const int64_t upper = std::min(std::max(step.has_start ? normalize(step.start) : n - 1, int64_t(-1)), n - 1);
+				const int64_t lower = std::min(std::max(step.has_end ? normalize(step.end) : -n - 1, int64_t(-1)), n - 1);
+				for (int64_t i = upper; lower < i; i += step.step) {
+					out.push_back(ut->get_data_list(i));
+				}
+			}
+		}
 
-								for (size_t x = 0; x < Vec.size(); x += 2) {
-									if (!Vec[x].is_key) {
-										exit(1);
-									}
-									if (Vec[x + 1].is_key) {
-										exit(1);
-									}
-									nestedUT[braceNum]->add_item_type(pool, (Vec[x].idx), Vec[x].idx2, Vec[x].len, 
-																			(Vec[x + 1].idx), Vec[x + 1].idx2, Vec[x + 1].len,
-																			buf, string_buf, Vec[x].id, Vec[x + 1].id);
-									++pool;
-								}
-							}
-							else {
-								nestedUT[braceNum]->reserve_data_list(nestedUT[braceNum]->get_data_size() + Vec.size());
+		bool Test(const Step& step, const UserType* ut) const {
+			const UserType* x = step.path.Get(ut);
+			if (step.op == Op::EXISTS) {
+				return x != nullptr;
+			}
 
-								for (size_t x = 0; x < Vec.size(); x += 1) {
-									if (Vec[x].is_key) {
-										exit(1);
-									}
-									nestedUT[braceNum]->add_item_type(pool, (Vec[x].idx), Vec[x].idx2, Vec[x].len, buf, string_buf, Vec[x].id);
-									++pool;
-								}
-							}
+			int cmp = 0;
+			bool ordered = false; // number or string, < > can be used.
+			const bool comparable = x && x->is_item_type() && Compare(x->get_value().data, step.literal, cmp, ordered);
+
+			switch (step.op) {
+			case Op::EQ:
+				return comparable && cmp == 0;
+			case Op::NE:
+				return !(comparable && cmp == 0);
+			case Op::LT:
+				return comparable && ordered && cmp < 0;
+			case Op::LE:
+				return comparable && ordered && cmp <= 0;
+			case Op::GT:
+				return comparable && ordered && cmp > 0;
+			case Op::GE:
+				return comparable && ordered && cmp >= 0;
+			default:
+				return false;
+			}
+		}
 
-							Vec.clear();
-						}
+		// false : different types.
+		static bool Compare(const Data& x, const Data& literal, int& cmp, bool& ordered) {
+			using simdjson::internal::tape_type;
 
-						if (key.is_key) {
+			switch (literal.type) {
+			case tape_type::DOUBLE:
+			{
+				double value;
+				if (x.type == tape_type::INT64) {
+					value = double(x.int_val);
+				}
+				else if (x.type == tape_type::UINT64) {
+					value = double(x.uint_val);
+				}
+				else if (x.type == tape_type::DOUBLE) {
+					value = x.float_val;
+				}
+				else {
+					return false;
+				}
+				if (value != value) { // NaN
+					return false;
+				}
+				cmp = value < literal.float_val ? -1 : (value > literal.float_val ? 1 : 0);
+				ordered = true;
+				return true;
+			}
+			case tape_type::STRING:
+				if (x.type != tape_type::STRING) {
+					return false;
+				}
+				{
+					const int c = x.get_str_val().compare(literal.get_str_val());
+					cmp = c < 0 ? -1 : (c > 0 ? 1 : 0);
+				}
+				ordered = true;
+				return true;
+			default: // true, false, null
+				if (x.type != literal.type) {
+					return false;
+				}
+				cmp = 0;
+				return true;
+			}
+		}
+
+		Key MakeKey(const Step& step) const {
+			Key key(step.key);
+			key.table = table;
+			key.sym = step.sym;
+			return key;
+		}
+
+		static Step MakeStep(StepType type) {
+			Step step;
+			step.type = type;
+			return step;
+		}
+
+		Step MakeKeyStep(StepType type, std::string&& key) const {
+			Step step = MakeStep(type);
+			step.key = std::move(key);
+			if (table) {
+				step.sym = table->Find(step.key);
+			}
+			return step;
+		}
+
+		static void SkipSpace(std::string_view path, size_t& i) {
+			while (i < path.size() && (path[i] == ' ' || path[i] == '\t' || path[i] == '\n' || path[i] == '\r')) {
+				++i;
+			}
+		}
+
+		static void Expect(std::string_view path, size_t& i, char c) {
+			SkipSpace(path, i);
+			if (i >= path.size() || path[i] != c) {
+				throw "Error in JSONPath, ] or ) is missing";
+			}
+			++i;
+		}
+
+		// .name, up to . [ space or an operator.
+		static std::string ParseName(std::string_view path, size_t& i) {
+			const size_t start = i;
+			while (i < path.size() && !std::strchr(".[] \t\n\r()<>=!,", path[i])) {
+				++i;
+			}
+			return std::string(path.substr(start, i - start));
+		}
+
+		// 'name' or "name", \ escapes the next char.
+		static std::string ParseQuoted(std::string_view path, size_t& i) {
+			const char quote = path[i];
+			std::string str;
+			++i;
+			while (i < path.size() && path[i] != quote) {
+				if (path[i] == '\\' && i + 1 < path.size()) {
+					++i;
+				}
+				str.push_back(path[i]);
+				++i;
+			}
+			if (i >= path.size()) {
+				throw "Error in JSONPath, string is not closed";
+			}
+			++i;
+			return str;
+		}
+
+		static bool ParseInt(std::string_view path, size_t& i, int64_t& x) {
+			SkipSpace(path, i);
+			size_t j = i;
+			const bool negative = j < path.size() && path[j] == '-';
+			if (negative) {
+				++j;
+			}
+			if (j >= path.size() || path[j] < '0' || path[j] > '9') {
+				return false;
+			}
+			x = 0;
+			for (; j < path.size() && path[j] >= '0' && path[j] <= '9'; ++j) {
+				x = x * 10 + (path[j] - '0');
+			}
+			x = negative ? -x : x;
+			i = j;
+			return true;
+		}
+
+		// [*] ['name'] [n] [start:end:step] [?(...)]
+		Step ParseBracket(std::string_view path, size_t& i) {
+			++i; // [
+			SkipSpace(path, i);
+			if (i >= path.size()) {
+				throw "Error in JSONPath, ] is missing";
+			}
+
+			Step step;
+			if (path[i] == '*') {
+				++i;
+				step = MakeStep(StepType::WILDCARD);
+			}
+			else if (path[i] == '\'' || path[i] == '"') {
+				step = MakeKeyStep(StepType::CHILD, ParseQuoted(path, i));
+			}
+			else if (path[i] == '?') {
+				++i;
+				step = ParseFilter(path, i);
+			}
+			else {
+				int64_t x = 0;
+				const bool has_x = ParseInt(path, i, x);
+				SkipSpace(path, i);
+				if (i < path.size() && path[i] == ':') {
+					++i;
+					step = MakeStep(StepType::SLICE);
+					step.has_start = has_x;
+					step.start = x;
+					step.has_end = ParseInt(path, i, step.end);
+					SkipSpace(path, i);
+					if (i < path.size() && path[i] == ':') {
+						++i;
+						if (!ParseInt(path, i, step.step)) {
+							step.step = 1;
+						}
+					}
+				}
+				else if (has_x) {
+					step = MakeStep(StepType::INDEX);
+					step.index = x;
+				}
+				else {
+					throw "Error in JSONPath, wrong [ ]";
+				}
+			}
+			Expect(path, i, ']');
+			return step;
+		}
+
+		// ?(@.a.b op literal), ( ) can be omitted.
+		Step ParseFilter(std::string_view path, size_t& i) {
+			Step step = MakeStep(StepType::FILTER);
+
+			SkipSpace(path, i);
+			const bool paren = i < path.size() && path[i] == '(';
+			if (paren) {
+				++i;
+				SkipSpace(path, i);
+			}
+			if (i >= path.size() || path[i] != '@') {
+				throw "Error in JSONPath, filter must start with @";
+			}
+			++i;
+
+			// @.a['b'][0] -> JSON Pointer /a/b/0
+			std::string pointer;
+			auto add = [&pointer](std::string_view key) {
+				pointer.push_back('/');
+				for (char c : key) {
+					if (c == '~') {
+						pointer += "~0";
+					}
+					else if (c == '/') {
+						pointer += "~1";
+					}
+					else {
+						pointer.push_back(c);
+					}
+				}
+			};
+			while (i < path.size()) {
+				if (path[i] == '.') {
+					++i;
+					std::string name = ParseName(path, i);
+					if (name.empty()) {
+						throw "Error in JSONPath, no name after . in filter";
+					}
+					add(name);
+				}
+				else if (path[i] == '[') {
+					++i;
+					SkipSpace(path, i);
+					int64_t x;
+					if (i < path.size() && (path[i] == '\'' || path[i] == '"')) {
+						add(ParseQuoted(path, i));
+					}
+					else if (ParseInt(path, i, x) && x >= 0) {
+						add(std::to_string(x));
+					}
+					else {
+						throw "Error in JSONPath, wrong [ ] in filter";
+					}
+					Expect(path, i, ']');
+				}
+				else {
+					break;
+				}
+			}
+			step.path = JsonPointer(pointer, table);
+
+			SkipSpace(path, i);
+			const std::string_view rest = path.substr(i);
+			if (rest.substr(0, 2) == "==") { step.op = Op::EQ; i += 2; }
+			else if (rest.substr(0, 2) == "!=") { step.op = Op::NE; i += 2; }
+			else if (rest.substr(0, 2) == "<=") { step.op = Op::LE; i += 2; }
+			else if (rest.substr(0, 2) == ">=") { step.op = Op::GE; i += 2; }
+			else if (rest.substr(0, 1) == "<") { step.op = Op::LT; i += 1; }
+			else if (rest.substr(0, 1) == ">") { step.op = Op::GT; i += 1; }
+
+			if (step.op != Op::EXISTS) {
+				SkipSpace(path, i);
+				const std::string_view literal = path.substr(i);
+				if (!literal.empty() && (literal[0] == '\'' || literal[0] == '"')) {
+					step.literal.set_str_val(ParseQuoted(path, i));
+				}
+				else if (literal.substr(0, 4) == "true") {
+					step.literal.type = simdjson::internal::tape_type::TRUE_VALUE;
+					i += 4;
+				}
+				else if (literal.substr(0, 5) == "false") {
+					step.literal.type = simdjson::internal::tape_type::FALSE_VALUE;
+					i += 5;
+				}
+				else if (literal.substr(0, 4) == "null") {
+					step.literal.type = simdjson::internal::tape_type::NULL_VALUE;
+					i += 4;
+				}
+				else {
+					size_t len = 0;
+					while (len < literal.size() && std::strchr("+-0123456789.eE", literal[len]) && literal[len] != '\0') {
+						++len;
+					}
+					const std::string number(literal.substr(0, len));
+					char* number_end = nullptr;
+					const double x = len > 0 ? std::strtod(number.c_str(), &number_end) : 0;
+					if (len == 0 || number_end != number.c_str() + len) {
+						throw "Error in JSONPath, wrong literal in filter";
+					}
+					step.literal.type = simdjson::internal::tape_type::DOUBLE;
+					step.literal.float_val = x;
+					i += len;
+				}
+			}
+
+			if (paren) {
+				Expect(path, i, ')');
+			}
+			return step;
+		}
+	};
+
+	// paths to build, for Parser::set_projection. JSON Pointers, and "*" : any key or index.
+	//   ex) Projection({ "/type", "/features/*/properties/BLOCK_NUM" }), "" : the whole document.
+	// containers on the way to a path are kept ( with only the kept members ), everything under the end of a path is kept.
+	class Projection {
+	public:
+		struct Node {
+			std::map<std::string, size_t, std::less<>> children;
+			size_t any = 0; // "*", 0 : none. ( nodes[0] is the root )
+			bool whole = false; // a path ends here.
+		};
+	private:
+		std::vector<Node> nodes; // empty : no projection.
+	public:
+		Projection() { }
+
+		// throws if a path is not a JSON Pointer.
+		explicit Projection(const std::vector<std::string>& paths) {
+			if (paths.empty()) {
+				return;
+			}
+			nodes.resize(1);
+
+			for (const auto& path : paths) {
+				const JsonPointer pointer(path);
+				size_t now = 0;
+				for (size_t i = 0; i < pointer.size() && !nodes[now].whole; ++i) {
+					now = AddChild(now, pointer.get_key(i));
+				}
+				nodes[now].whole = true;
+			}
+
+			// a key next to "*" also gets the paths under "*".
+			Spread(0);
+		}
+
+		bool empty() const {
+			return nodes.empty();
+		}
+
+		const Node* get_root() const {
+			return nodes.empty() ? nullptr : &nodes[0];
+		}
+
+		// nullptr : not kept.
+		const Node* Child(const Node* node, std::string_view key) const {
+			if (!node || node->whole) {
+				return node;
+			}
+			auto x = node->children.find(key);
+			if (x != node->children.end()) {
+				return &nodes[x->second];
+			}
+			return node->any ? &nodes[node->any] : nullptr;
+		}
+
+		const Node* Child(const Node* node, int64_t index) const {
+			if (!node || node->whole) {
+				return node;
+			}
+			if (node->children.empty()) {
+				return node->any ? &nodes[node->any] : nullptr;
+			}
+			char str[32];
+			auto result = std::to_chars(str, str + sizeof(str), index);
+			return Child(node, std::string_view(str, result.ptr - str));
+		}
+	private:
+		size_t AddChild(size_t node, std::string_view key) {
+			if (key == "*") {
+				if (!nodes[node].any) {
+					nodes[node].any = nodes.size();
+					nodes.emplace_back();
+				}
+				return nodes[node].any;
+			}
+			auto x = nodes[node].children.find(key);
+			if (x != nodes[node].children.end()) {
+				return x->second;
+			}
+			const size_t child = nodes.size();
+			nodes[node].children.emplace(std::string(key), child);
+			nodes.emplace_back(); // nodes[node] can be moved.
+			return child;
+		}
+
+		// paths under src -> dst.
+		void Merge(size_t dst, size_t src) {
+			if (nodes[dst].whole) {
+				return;
+			}
+			if (nodes[src].whole) {
+				nodes[dst].whole = true;
+				return;
+			}
+			const std::vector<std::pair<std::string, size_t>> children(nodes[src].children.begin(), nodes[src].children.end());
+			for (const auto& x : children) {
+				Merge(AddChild(dst, x.first), x.second);
+			}
+			if (nodes[src].any) {
+				Merge(AddChild(dst, "*"), nodes[src].any);
+			}
+		}
+
+		void Spread(size_t node) {
+			if (nodes[node].whole) {
+				return;
+			}
+			const std::vector<std::pair<std::string, size_t>> children(nodes[node].children.begin(), nodes[node].children.end());
+			for (const auto& x : children) {
+				if (nodes[node].any) {
+					Merge(x.second, nodes[node].any);
+				}
+				Spread(x.second);
+			}
+			if (nodes[node].any) {
+				Spread(nodes[node].any);
+			}
+		}
+	};
+
+
+	// pools on huge pages -> mapped length.
+	inline std::map<UserType*, size_t>& get_mapped_pools(std::mutex*& mtx) {
+		static std::mutex mapped_mtx;
+		static std::map<UserType*, size_t> mapped;
+		mtx = &mapped_mtx;
+		return mapped;
+	}
+
+	inline UserType* NewPool(int64_t n, simdjson::dom::huge_page_mode mode) {
+		if (n <= 0) {
+			n = 1;
+		}
+		if (mode != simdjson::dom::huge_page_mode::off) {
+			size_t mapped_len = 0;
+			char* x = simdjson::internal::allocate_huge_pages(size_t(n) * sizeof(UserType), mode, mapped_len);
+			if (x) {
+				std::mutex* mtx;
+				auto& mapped = get_mapped_pools(mtx);
+				std::lock_guard<std::mutex> guard(*mtx);
+				mapped[(UserType*)x] = mapped_len;
+				return (UserType*)x;
+			}
+		}
+		return (UserType*)calloc(n, sizeof(UserType));
+	}
+
+	inline void FreePool(UserType* pool) {
+		if (!pool) {
+			return;
+		}
+#if !defined(_WIN32)
+		{
+			std::mutex* mtx;
+			auto& mapped = get_mapped_pools(mtx);
+			std::lock_guard<std::mutex> guard(*mtx);
+			auto iter = mapped.find(pool);
+			if (iter != mapped.end()) {
+				munmap(pool, iter->second);
+				mapped.erase(iter);
+				return;
+			}
+		}
+#endif
+		free(pool);
+	}
+
+	inline void PoolManager::Clear() {
+		for (auto* pool : pools) {
+			FreePool(pool);
+		}
+		pools.clear();
+		pool_sizes.clear();
+		blocks.clear();
+		block_idx = 0;
+		dead_list_start = nullptr;
+		arenas.clear();
+		key_table.reset();
+		next_slab_size = FIRST_SLAB_SIZE;
+		capacity = 0;
+		free_num = 0;
+		cached_num = 0;
+		slab_num = 0;
+	}
+
+	inline void PoolManager::DestroyNodes() {
+		std::lock_guard<std::mutex> guard(mtx);
+
+		for (size_t i = 0; i < pools.size(); ++i) {
+			for (int64_t j = 0; j < pool_sizes[i]; ++j) {
+				UserType* x = pools[i] + j;
+				if (x->alloc_type == PoolManager::Type::FROM_POOL) {
+					x->~UserType();
+					x->alloc_type = PoolManager::Type::DEAD;
+				}
+			}
+		}
+
+		blocks.clear();
+		block_idx = 0;
+		dead_list_start = nullptr;
+		for (size_t i = 0; i < pools.size(); ++i) {
+			if (pool_sizes[i] > 0) {
+				blocks.push_back(Block{ 0, pool_sizes[i], pools[i] });
+			}
+		}
+		free_num = capacity;
+		cached_num = 0;
+	}
+
+	inline void PoolManager::Release(std::vector<UserType*>& pools, std::vector<Block>& blocks) {
+		std::lock_guard<std::mutex> guard(mtx);
+
+		for (UserType* x = dead_list_start; x; x = x->next_dead) {
+			this->blocks.push_back(Block{ 0, 1, x });
+		}
+		this->blocks.erase(this->blocks.begin(), this->blocks.begin() + block_idx);
+
+		pools = std::move(this->pools);
+		blocks = std::move(this->blocks);
+		this->pools.clear();
+		this->pool_sizes.clear();
+		this->blocks.clear();
+		block_idx = 0;
+		dead_list_start = nullptr;
+		next_slab_size = FIRST_SLAB_SIZE;
+		capacity = 0;
+		free_num = 0;
+		cached_num = 0;
+		slab_num = 0;
+	}
+
+	inline PoolManager::Stats PoolManager::get_stats() {
+		std::lock_guard<std::mutex> guard(mtx);
+
+		Stats stats;
+		stats.live_nodes = std::max<int64_t>(0, capacity - free_num - cached_num);
+		stats.free_nodes = free_num;
+		stats.cached_nodes = cached_num;
+		stats.pool_num = (int64_t)pools.size() - slab_num;
+		stats.slab_num = slab_num;
+		stats.bytes = capacity * (int64_t)sizeof(UserType);
+		return stats;
+	}
+
+	inline MemoryUsage PoolManager::memory_usage(const UserType* root) {
+		MemoryUsage x;
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			x.nodes = size_t(capacity) * sizeof(UserType); // pools of unknown size are not counted, like Stats.
+		}
+		for (auto& arena : arenas) {
+			x.AddArena(arena);
+		}
+		if (key_table) {
+			x.strings += key_table->get_bytes();
+		}
+		if (!root) {
+			return x;
+		}
+
+		std::vector<const UserType*> stack{ root };
+		while (!stack.empty()) {
+			const UserType* ut = stack.back();
+			stack.pop_back();
+
+			if (ut->alloc_type != PoolManager::Type::FROM_POOL) { // root, clone()...
+				x.nodes += sizeof(UserType);
+			}
+			x.strings += ut->value.key.get_heap_size() + ut->value.data.get_heap_size();
+			if (const auto* box = ut->box) {
+				x.child_lists += box->data.get_heap_size() + (box->in_arena ? 0 : sizeof(*box)); // in an arena : counted with the arena.
+				if (const KeyIndex* index = box->index.load(std::memory_order_acquire)) {
+					x.indexes += index->get_bytes();
+				}
+			}
+			for (auto* child : ut->list()) {
+				stack.push_back(child);
+			}
+		}
+		return x;
+	}
+
+	inline UserType* PoolManager::Alloc() {
+		UserType* x;
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			x = TakeOne();
+		}
+		new (x) UserType();
+		x->alloc_type = PoolManager::Type::FROM_POOL;
+		return x;
+	}
+
+	inline void PoolManager::Alloc(UserType** out, int64_t n) {
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			for (int64_t i = 0; i < n; ++i) {
+				out[i] = TakeOne();
+			}
+		}
+		for (int64_t i = 0; i < n; ++i) {
+			new (out[i]) UserType();
+			out[i]->alloc_type = PoolManager::Type::FROM_POOL;
+		}
+	}
+
+	inline void PoolManager::DeAlloc(UserType* ut) {
+		if (ut->alloc_type != PoolManager::Type::FROM_POOL) { // STATIC, or dead already.
+			return;
+		}
+		ut->~UserType();
+		ut->alloc_type = PoolManager::Type::DEAD;
+
+		std::lock_guard<std::mutex> guard(mtx);
+		ut->next_dead = dead_list_start;
+		dead_list_start = ut;
+		++free_num;
+	}
+
+	// locked by caller.
+	inline UserType* PoolManager::TakeOne() {
+		// 1. dead list.
+		if (dead_list_start) {
+			UserType* x = dead_list_start;
+			dead_list_start = x->next_dead;
+			--free_num;
+			return x;
+		}
+
+		// 2. free blocks, the empty ones are skipped once.
+		while (block_idx < blocks.size() && blocks[block_idx].size <= 0) {
+			++block_idx;
+		}
+
+		// 3. new slab.
+		if (block_idx == blocks.size()) {
+			AddSlab();
+		}
+
+		Block& block = blocks[block_idx];
+		UserType* x = block.pool + block.start;
+		++block.start;
+		--block.size;
+		--free_num;
+		return x;
+	}
+
+	// locked by caller.
+	inline UserType* PoolManager::TakeFree(int64_t n) {
+		UserType* list = nullptr;
+		for (int64_t i = 0; i < n; ++i) {
+			UserType* x = TakeOne();
+			x->next_dead = list;
+			list = x;
+		}
+		return list;
+	}
+
+	// locked by caller.
+	inline void PoolManager::AddSlab() {
+		const int64_t n = next_slab_size;
+		UserType* slab = NewPool(n);
+		if (!slab) {
+			throw std::bad_alloc();
+		}
+		pools.push_back(slab);
+		pool_sizes.push_back(n);
+		blocks.push_back(Block{ 0, n, slab });
+		capacity += n;
+		free_num += n;
+		++slab_num;
+		next_slab_size = n * 2 < MAX_SLAB_SIZE ? n * 2 : MAX_SLAB_SIZE;
+	}
+
+	inline void PoolManager::Count() {
+		capacity = 0;
+		for (auto x : pool_sizes) {
+			capacity += x;
+		}
+		free_num = 0;
+		for (const auto& x : blocks) {
+			free_num += x.size;
+		}
+	}
+
+	inline void PoolManager::Take(PoolManager& other) {
+		pools = std::move(other.pools);
+		pool_sizes = std::move(other.pool_sizes);
+		blocks = std::move(other.blocks);
+		block_idx = other.block_idx;
+		dead_list_start = other.dead_list_start;
+		arenas = std::move(other.arenas);
+		key_table = std::move(other.key_table);
+		next_slab_size = other.next_slab_size;
+		capacity = other.capacity;
+		free_num = other.free_num;
+		cached_num = other.cached_num;
+		slab_num = other.slab_num;
+
+		other.Clear(); // moved-from vectors -> empty.
+	}
+
+	inline UserType* PoolManager::Cache::Alloc() {
+		if (!free_list) {
+			std::lock_guard<std::mutex> guard(manager->mtx);
+			free_list = manager->TakeFree(BATCH);
+			free_num = BATCH;
+			manager->cached_num += free_num - synced_num;
+			synced_num = free_num;
+		}
+
+		UserType* x = free_list;
+		free_list = x->next_dead;
+		--free_num;
+
+		new (x) UserType();
+		x->alloc_type = PoolManager::Type::FROM_POOL;
+		return x;
+	}
+
+	inline void PoolManager::Cache::DeAlloc(UserType* ut) {
+		if (ut->alloc_type != PoolManager::Type::FROM_POOL) { // STATIC, or dead already.
+			return;
+		}
+		ut->~UserType();
+		ut->alloc_type = PoolManager::Type::DEAD;
+
+		ut->next_dead = free_list;
+		free_list = ut;
+		++free_num;
+
+		if (free_num >= 2 * BATCH) {
+			Return(BATCH);
+		}
+	}
+
+	inline void PoolManager::Cache::Return(int64_t n) {
+		UserType* first = free_list;
+		UserType* last = nullptr;
+		int64_t count = 0;
+		for (; count < n && free_list; ++count) {
+			last = free_list;
+			free_list = free_list->next_dead;
+		}
+		free_num -= count;
+
+		std::lock_guard<std::mutex> guard(manager->mtx);
+		if (last) {
+			last->next_dead = manager->dead_list_start;
+			manager->dead_list_start = first;
+			manager->free_num += count;
+		}
+		manager->cached_num += free_num - synced_num;
+		synced_num = free_num;
+	}
+}
+
+
+namespace claujson {
+	class LoadData
+	{
+		friend class Cursor;
+	public:
+
+		// -2 : object and array are mixed, wrong input.
+		static int Merge(class UserType* next, class UserType* ut, class UserType** ut_next)
+		{
+
+			// check!!
+			while (ut->get_data_size() >= 1
+				&& (ut->get_data_list(0)->is_user_type()) && (ut->get_data_list(0))->is_virtual())
+			{
+				ut = (UserType*)ut->get_data_list(0);
+			}
+
+			bool chk_ut_next = false;
+
+			while (true) {
+
+				class UserType* _ut = ut;
+				class UserType* _next = next;
+
+				if (_next->is_array() && _ut->is_object()) {
+					return -2;
+				}
+				if (_next->is_object() && _ut->is_array()) {
+					return -2;
+				}
+
+
+				if (ut_next && _ut == *ut_next) {
+					*ut_next = _next;
+					chk_ut_next = true;
+				}
+
+
+
+				size_t _size = _ut->get_data_size(); // bug fix.. _next == _ut?
+				// checked before any link, so nothing is moved yet if it is wrong.
+				for (size_t i = 0; i < _size; ++i) {
+					UserType* x = _ut->get_data_list(i);
+					if (x->is_user_type() && x->is_virtual()) {
+						continue;
+					}
+					if ((_next->is_array() && x->value.key.is_key) || (_next->is_object() && !x->value.key.is_key)) {
+						return -2;
+					}
+				}
+				for (size_t i = 0; i < _size; ++i) {
+					if (_ut->get_data_list(i)->is_user_type()) {
+						if (((UserType*)_ut->get_data_list(i))->is_virtual()) {
+							//_ut->get_user_type_list(i)->used();
+						}
+						else {
+							_next->LinkUserType(_ut->get_data_list(i));
+							_ut->get_data_list(i) = nullptr;
+						}
+					}
+					else { // item type.
+						_next->LinkItemType(std::move(_ut->get_data_list(i)));
+					}
+				}
+
+				_ut->remove_all();
+
+				ut = ut->get_parent();
+				next = next->get_parent();
+
+
+				if (next && ut) {
+					//
+				}
+				else {
+					// right_depth > left_depth
+					if (!next && ut) {
+						return -1;
+					}
+					else if (next && !ut) {
+						return 1;
+					}
+
+					return 0;
+				}
+			}
+		}
+
+	private:
+		// result of one __LoadData. root - __global[i], (left) virtual nodes are in root->data[0], root->data[0]->data[0], ...
+		// next - last not closed (real) container in root.
+		struct Fragment {
+			UserType* root;
+			UserType* next;
+		};
+
+		// merge right into left, left and right are neighbors. (left is before right) false : wrong input.
+		static bool MergeFragment(Fragment& left, Fragment& right) {
+			int64_t left_depth = 0; // depth of left.next from left.root
+			for (UserType* x = left.next; x != left.root; x = x->get_parent()) {
+				++left_depth;
+			}
+
+			std::vector<UserType*> chain{ right.root }; // right.root, virtual nodes..
+			while (chain.back()->get_data_size() >= 1 && chain.back()->get_data_list(0)->is_user_type()
+				&& chain.back()->get_data_list(0)->is_virtual()) {
+				chain.push_back(chain.back()->get_data_list(0));
+			}
+			const int64_t right_virtual_num = chain.size() - 1;
+
+			int err = Merge(left.next, right.root, &right.next);
+
+			if (-2 == err) {
+				return false;
+			}
+			if (-1 == err) {
+				// right closes more than left opened, left.root`s data are in the virtual node closing it.
+				UserType* ut = chain[right_virtual_num - left_depth];
+
+				for (size_t i = 0; i < left.root->get_data_size(); ++i) {
+					ut->add_user_type(left.root->get_data_list(i));
+					left.root->get_data_list(i) = nullptr;
+				}
+				left.root->remove_all();
+
+				left.root = right.root;
+			}
+			left.next = right.next;
+			return true;
+		}
+
+		struct Test {
+			int64_t idx = 0;
+			int64_t idx2 = 0;
+			int64_t len = 0;
+			uint64_t id = 0;
+			bool is_key = false;
+		};
+
+		// roots, next, err - results of __LoadData, in document order.
+		static bool MergeAll(std::vector<UserType*>& roots, std::vector<UserType*>& next, const std::vector<int>& err,
+			class UserType& global, ThreadPool& thread_pool, int thr_num) {
+			class UserType _global;
+
+			for (size_t i = 0; i < err.size(); ++i) {
+				switch (err[i]) {
+				case 0:
+					break;
+				case -1:
+				case -4:
+					std::cout << "Syntax Error\n"; return false;
+					break;
+				case -2:
+					std::cout << "error final state is not last_state!\n"; return false;
+					break;
+				case -3:
+					std::cout << "error x > buffer + buffer_len:\n"; return false;
+					break;
+				case -5:
+					std::cout << "not enough memory\n"; return false;
+					break;
+				default:
+					std::cout << "unknown parser error\n"; return false;
+					break;
+				}
+			}
+
+			// Merge
+			//try
+			{
+				// non-empty fragments, in document order.
+				std::vector<Fragment> frags;
+				frags.reserve(roots.size());
+
+				for (size_t i = 0; i < roots.size(); ++i) {
+					if (roots[i]->get_data_size() > 0) {
+						frags.push_back(Fragment{ roots[i], next[i] });
+					}
+				}
+
+				// tree reduction, log(N) rounds, in each round neighbor pairs are merged concurrently.
+				for (size_t stride = 1; stride < frags.size(); stride *= 2) {
+					const int64_t pair_num = (frags.size() - stride + 2 * stride - 1) / (2 * stride);
+					std::vector<int> merged(pair_num, 0); // not vector<bool>, written concurrently.
+
+					thread_pool.ParallelFor(pair_num, thr_num, [&](int64_t j) {
+						const size_t left = j * 2 * stride;
+						merged[j] = MergeFragment(frags[left], frags[left + stride]);
+					});
+
+					for (int x : merged) {
+						if (!x) {
+							std::cout << "Syntax Error\n"; return false;
+						}
+					}
+				}
+
+				if (!frags.empty()) {
+					Fragment& all = frags[0];
+
+					if (all.root->get_data_list(0)->is_user_type()
+						&& ((UserType*)all.root->get_data_list(0))->is_virtual()) {
+						std::cout << "not valid file1\n";
+						throw 1;
+					}
+					if (all.next != all.root) {
+						std::cout << "not valid file5\n";
+						throw 5;
+					}
+
+					int err = Merge(&_global, all.root, &all.next);
+					if (-1 == err) {
+						std::cout << "not valid file3\n";
+						throw 3;
+					}
+					if (-2 == err) {
+						std::cout << "Syntax Error\n"; return false;
+					}
+				}
+			}
+			//catch (...) {
+				//throw "in Merge, error";
+			//	return false;
+			//}
+			//
+
+			if (_global.get_data_size() > 1) {
+				std::cout << "not valid file6\n";
+				throw 6;
+			}
+
+			//int a = clock();
+
+			if (-2 == Merge(&global, &_global, nullptr)) {
+				std::cout << "Syntax Error\n"; return false;
+			}
+
+			return true;
+		}
+
+		// pool - for this chunk, at least token_arr_len nodes.
+		// token_num - tokens in imple->structural_indexes that can be read, at least token_arr_start + token_arr_len + 2 or all.
+		static bool __LoadData(claujson::UserType* pool, const simdjson::dom::parser::loaded_bytes_ptr& buf, size_t buf_len,
+			const std::unique_ptr<uint8_t[]>& string_buf,
+			const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple,
+			int64_t token_arr_start, size_t token_arr_len, class UserType* _global,
+			int start_state, int last_state, class UserType** next, int* err, int no, UserType*& after_pool, int64_t token_num, StringArena* arena, KeyCache* keys, LazyInput* lazy)
+		{
+			//int a = clock();
+
+			simdjson::dom::parser test;
+
+
+			std::vector<Test> Vec;
+
+			if (token_arr_len <= 0) {
+				*next = nullptr;
+				return false;
+			}
+
+			class UserType& global = *_global;
+
+			int state = start_state;
+			size_t braceNum = 0;
+			std::vector< class UserType* > nestedUT(1);
+
+			nestedUT.reserve(10);
+			nestedUT[0] = &global;
+
+			// child lists of open containers are built in these ( one per depth, reused ), sealed into arena when closed.
+			std::vector<ChildList> scratch(1);
+
+			int64_t count = 0;
+
+			Test key; bool is_before_comma = false;
+			bool is_now_comma = false;
+
+			// eager conversion, a wrong value is ROOT ( see Convert ), a key must be a string.
+			auto converted = [lazy](const UserType* x, bool keyed) {
+				return lazy || ((!keyed || x->value.key.type == simdjson::internal::tape_type::STRING)
+					&& (!x->is_item_type() || x->value.data.type != simdjson::internal::tape_type::ROOT));
+			};
+
+			// items in Vec -> nestedUT[braceNum], keyed : pairs of key and value. false : wrong structure or value.
+			auto add_items = [&](bool keyed) {
+				UserType* ut = nestedUT[braceNum];
+				if (keyed ? ut->is_array() : ut->is_object()) {
+					return false;
+				}
+				if (keyed) {
+					if (Vec.size() % 2 == 1) {
+						return false;
+					}
+					ut->reserve_data_list(ut->get_data_size() + Vec.size() / 2);
+
+					for (size_t x = 0; x < Vec.size(); x += 2) {
+						if (!Vec[x].is_key || Vec[x + 1].is_key) {
+							return false;
+						}
+						ut->add_item_type(pool, Vec[x].idx, Vec[x].idx2, Vec[x].len, Vec[x + 1].idx, Vec[x + 1].idx2, Vec[x + 1].len,
+							buf, string_buf, Vec[x].id, Vec[x + 1].id, arena, keys, lazy);
+						if (!converted(pool, true)) {
+							return false;
+						}
+						++pool;
+					}
+				}
+				else {
+					ut->reserve_data_list(ut->get_data_size() + Vec.size());
+
+					for (size_t x = 0; x < Vec.size(); x += 1) {
+						if (Vec[x].is_key) {
+							return false;
+						}
+						ut->add_item_type(pool, Vec[x].idx, Vec[x].idx2, Vec[x].len, buf, string_buf, Vec[x].id, arena, keys, lazy);
+						if (!converted(pool, false)) {
+							return false;
+						}
+						++pool;
+					}
+				}
+				Vec.clear();
+				return true;
+			};
+
+			for (int64_t i = 0; i < token_arr_len; ++i) {
+
+				const simdjson::internal::tape_type type = (simdjson::internal::tape_type)buf[imple->structural_indexes[token_arr_start + i]];
+				
+
+				switch (state)
+				{
+				case 0:
+				{
+					if (is_before_comma && type == simdjson::internal::tape_type::COMMA) {
+						std::cout << "before is comma\n";
+						*err = -1;
+						return false;
+						//
+					}
+					if (!is_now_comma && type == simdjson::internal::tape_type::COMMA) {
+						std::cout << "now is not comma\n";
+						*err = -1;
+						return false;
+						//
+					}
+
+					if (type == simdjson::internal::tape_type::COMMA) {
+						is_before_comma = true;
+					}
+					else {
+						is_before_comma = false;
+					}
+
+					if (type == simdjson::internal::tape_type::COMMA) {
+						if (token_arr_start + i + 1 < token_num) {
+							const simdjson::internal::tape_type _type =
+								(simdjson::internal::tape_type)buf[imple->structural_indexes[token_arr_start + i + 1]];
+
+							if (_type == simdjson::internal::tape_type::END_ARRAY || _type == simdjson::internal::tape_type::END_OBJECT) {
+								*err = -1;
+								return false;
+								//
+							}
+
+							continue;
+						}
+						else {
+							*err = -1;
+							return false;
+						}
+					}
+
+					if (type == simdjson::internal::tape_type::COLON) {
+						*err = -1;
+						return false;
+						//
+					}
+
+					if (token_arr_start + i + 1 < token_num) {
+						const simdjson::internal::tape_type _type = // next_type
+							(simdjson::internal::tape_type)buf[imple->structural_indexes[token_arr_start + i + 1]];
+
+						if (_type == simdjson::internal::tape_type::END_ARRAY || _type == simdjson::internal::tape_type::END_OBJECT) {
+							is_now_comma = false;
+						}
+						else if (type == simdjson::internal::tape_type::START_ARRAY || type == simdjson::internal::tape_type::START_OBJECT) {
+							is_now_comma = false;
+						}
+						else {
+							is_now_comma = true;
+						}
+					}
+					else {
+						is_now_comma = false;
+					}
+
+					// Left 1
+					//else
+					if (type == simdjson::internal::tape_type::START_OBJECT ||
+						type == simdjson::internal::tape_type::START_ARRAY) { // object start, array start
+
+
+
+						if (!Vec.empty() && !add_items(Vec[0].is_key)) {
+							*err = -1;
+							return false;
+						}
+
+						if (key.is_key ? nestedUT[braceNum]->is_array() : nestedUT[braceNum]->is_object()) {
+							*err = -1;
+							return false;
+						}
+						if (key.is_key) {
 							nestedUT[braceNum]->add_user_type(pool, key.idx, key.idx2, key.len, buf, string_buf, 
-								type == simdjson::internal::tape_type::START_OBJECT ? 0 : 1, key.id); // object vs array
+								type == simdjson::internal::tape_type::START_OBJECT ? 0 : 1, key.id, arena, keys, lazy); // object vs array
+							if (!converted(pool, true)) {
+								*err = -1;
+								return false;
+							}
 							key.is_key = false; ++pool;
 						}
 						else {
-							nestedUT[braceNum]->add_user_type(pool, type == simdjson::internal::tape_type::START_OBJECT ? 0 : 1);
-							++pool;
+							nestedUT[braceNum]->add_user_type(pool, type == simdjson::internal::tape_type::START_OBJECT ? 0 : 1);
+							++pool;
+						}
+
+
+						class UserType* pTemp = nestedUT[braceNum]->get_data_list(nestedUT[braceNum]->get_data_size() - 1);
+
+						braceNum++;
+
+						/// new nestedUT
+						if (nestedUT.size() == braceNum) {
+							nestedUT.push_back(nullptr);
+						}
+
+						/// initial new nestedUT.
+						nestedUT[braceNum] = pTemp;
+
+						if (arena) {
+							if (scratch.size() == braceNum) {
+								scratch.emplace_back();
+							}
+							std::swap(pTemp->make_list(arena), scratch[braceNum]);
+						}
+
+						state = 0;
+
+					}
+					// Right 2
+					else if (type == simdjson::internal::tape_type::END_OBJECT ||
+						type == simdjson::internal::tape_type::END_ARRAY) {
+
+						if (type == simdjson::internal::tape_type::END_ARRAY && nestedUT[braceNum]->is_object()) {
+							std::cout << "{]";
+							*err = -1;
+							return false;
+						}
+						
+						if (type == simdjson::internal::tape_type::END_OBJECT && nestedUT[braceNum]->is_array()) {
+							std::cout << "[}";
+							*err = -1;
+							return false;
+						}
+
+						state = 0;
+
+						if (!Vec.empty() && !add_items(type == simdjson::internal::tape_type::END_OBJECT)) {
+							*err = -1;
+							return false;
+						}
+
+
+						if (braceNum == 0) {
+							class UserType ut; //
+
+							ut.add_user_type(pool, type == simdjson::internal::tape_type::END_OBJECT ? 2 : 3); // json -> "var_name" = val  
+							++pool;
+
+							for (size_t i = 0; i < nestedUT[braceNum]->get_data_size(); ++i) {
+								ut.get_data_list(0)->add_user_type(nestedUT[braceNum]->get_data_list(i));
+								nestedUT[braceNum]->get_data_list(i) = nullptr;
+							}
+
+							nestedUT[braceNum]->remove_all();
+							nestedUT[braceNum]->add_user_type(ut.get_data_list(0));
+
+							ut.get_data_list(0) = nullptr;
+
+							braceNum++;
+						}
+						else if (arena) {
+							nestedUT[braceNum]->make_list(arena).Seal(*arena, scratch[braceNum]);
+						}
+
+						{
+							if (braceNum < nestedUT.size()) {
+								nestedUT[braceNum] = nullptr;
+							}
+
+							braceNum--;
+						}
+					}
+					else {
+						{
+							Test data;
+
+							data.idx = imple->structural_indexes[token_arr_start + i];
+							data.id = token_arr_start + i;
+
+							if (token_arr_start + i + 1 < token_num) {
+								data.idx2 = imple->structural_indexes[token_arr_start + i + 1];
+							}
+							else {
+								data.idx2 = buf_len;
+							}
+
+							bool is_key = false;
+							if (token_arr_start + i + 1 < token_num && buf[imple->structural_indexes[token_arr_start + i + 1]] == ':') {
+								is_key = true;
+							}
+
+							if (is_key) {
+								data.is_key = true;
+							
+								if (token_arr_start + i + 2 < token_num) {
+									const simdjson::internal::tape_type _type = (simdjson::internal::tape_type)buf[imple->structural_indexes[token_arr_start + i + 2]];
+
+									if (_type == simdjson::internal::tape_type::START_ARRAY || _type == simdjson::internal::tape_type::START_OBJECT) {
+										key = std::move(data); 
+									}
+									else {
+										Vec.push_back(std::move(data)); 
+									}
+								}
+								else {
+									Vec.push_back(std::move(data));
+								}
+								++i;
+									
+								is_now_comma = false;
+							}
+							else {	
+								Vec.push_back(std::move(data));
+							}
+
+							state = 0;
+						}
+					}
+				
+				}
+				break;
+				default:
+					// syntax err!!
+					*err = -1;
+					return false; // throw "syntax error ";
+					break;
+				}
+			}
+
+			if (next) {
+				*next = nestedUT[braceNum];
+			}
+
+			if (!Vec.empty() && !add_items(Vec[0].is_key)) {
+				*err = -1;
+				return false;
+			}
+
+			if (state != last_state) {
+				*err = -2;
+				return false;
+				// throw STRING("error final state is not last_state!  : ") + toStr(state);
+			}
+
+			after_pool = pool;
+			//int b = clock();
+			//std::cout << "parse thread " << b - a << "ms\n";
+			return true;
+		}
+
+		// how many tokens after the cut point to look at for a shallow comma.
+		static const int64_t DIVISION_SEARCH_LEN = 4096;
+
+		// find a comma in [start, last], the one at the lowest depth (relative to start) in the search window,
+		// so Merge has less virtual node to fix up. same depth -> the first one.
+		static int64_t FindDivisionPlace(const simdjson::dom::parser::loaded_bytes_ptr& buf, const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, int64_t start, int64_t last)
+		{
+			int64_t depth = 0;
+			int64_t best = -1;
+			int64_t best_depth = 0;
+
+			if (last - start + 1 > DIVISION_SEARCH_LEN) {
+				last = start + DIVISION_SEARCH_LEN - 1;
+			}
+
+			for (int64_t a = start; a <= last; ++a) {
+				auto& x = imple->structural_indexes[a]; //  token_arr[a];
+				const simdjson::internal::tape_type type = (simdjson::internal::tape_type)buf[x];
+
+				switch ((int)type) {
+				case '{':
+				case '[':
+					++depth;
+					break;
+				case '}':
+				case ']':
+					--depth;
+					break;
+				case ',':
+					if (best == -1 || depth < best_depth) {
+						best = a + 1;
+						best_depth = depth;
+					}
+					break;
+				default:
+					break;
+				}
+			}
+			return best;
+		}
+
+		// estimated work of tokens [a, b) : bytes spanned (string copy, number parsing) + per token cost (node, Convert call).
+		static int64_t EstimateCost(const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, size_t buf_len, int64_t a, int64_t b) {
+			const int64_t TOKEN_COST = 32; // in bytes.
+
+			const int64_t end = b < imple->n_structural_indexes ? imple->structural_indexes[b] : buf_len;
+			const int64_t begin = a < imple->n_structural_indexes ? imple->structural_indexes[a] : buf_len;
+
+			return (end - begin) + (b - a) * TOKEN_COST;
+		}
+	public:
+
+		// start[0..thr_num] - start[i] : the i-th chunk has about EstimateCost(0, length) / thr_num of work.
+		static void SetDivisionStart(const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, size_t buf_len,
+			int64_t length, std::vector<int64_t>& start, int thr_num) {
+			const int64_t total = EstimateCost(imple, buf_len, 0, length);
+
+			start[0] = 0;
+			for (int i = 1; i < thr_num; ++i) {
+				const int64_t target = total / thr_num * i;
+
+				// cost is monotonic in b, binary search.
+				int64_t left = start[i - 1], right = length;
+				while (left < right) {
+					int64_t mid = left + (right - left) / 2;
+					if (EstimateCost(imple, buf_len, 0, mid) < target) {
+						left = mid + 1;
+					}
+					else {
+						right = mid;
+					}
+				}
+				start[i] = left;
+			}
+			start[thr_num] = length;
+		}
+
+		// chunk i is tokens [pivots[i], pivots[i + 1]), chunks start at a comma (or 0).
+		static void SetPivots(const simdjson::dom::parser::loaded_bytes_ptr& buf,
+			const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, int64_t length,
+			const std::vector<int64_t>& start, const int parse_num, std::vector<int64_t>& pivots)
+		{
+			const int pivot_num = parse_num - 1;
+
+			std::set<int64_t> _pivots;
+			//const int64_t num = token_arr_len; //
+
+			pivots.clear();
+
+			if (pivot_num > 0) {
+				std::vector<int64_t> pivot;
+				pivots.reserve(pivot_num);
+				pivot.reserve(pivot_num);
+
+				pivot.push_back(start[0]);
+
+				for (int i = 1; i < parse_num; ++i) {
+					pivot.push_back(FindDivisionPlace(buf, imple, start[i], start[i + 1] - 1));
+				}
+
+				for (size_t i = 0; i < pivot.size(); ++i) {
+					if (pivot[i] != -1) {
+						_pivots.insert(pivot[i]);
+					}
+				}
+
+				for (auto& x : _pivots) {
+					pivots.push_back(x);
+				}
+
+				pivots.push_back(length);
+			}
+			else {
+				pivots.push_back(start[0]);
+				pivots.push_back(length);
+			}
+		}
+
+		// the number of nodes __LoadData makes for tokens [start, end) : containers, values ( key + value -> one node ),
+		// and virtual nodes for closers whose opener is not in [start, end).
+		static int64_t CountNodes(const simdjson::dom::parser::loaded_bytes_ptr& buf,
+			const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, int64_t start, int64_t end, int64_t token_num)
+		{
+			const uint32_t* idx = imple->structural_indexes.get();
+			const char* str = buf.get();
+
+			int64_t count = 0;
+			int64_t depth = 0;
+
+			for (int64_t i = start; i < end; ++i) {
+				switch (str[idx[i]]) {
+				case '{':
+				case '[':
+					++count;
+					++depth;
+					break;
+				case '}':
+				case ']':
+					if (depth > 0) {
+						--depth;
+					}
+					else {
+						++count; // virtual node.
+					}
+					break;
+				case ',':
+				case ':':
+					break;
+				default:
+					// key -> counted with its value.
+					count += !(i + 1 < token_num && str[idx[i + 1]] == ':');
+					break;
+				}
+			}
+
+			return count;
+		}
+
+		// node_offsets[i] - where chunk i`s nodes start in the pool, node_offsets.back() - the pool size.
+		static int64_t SetNodeOffsets(const simdjson::dom::parser::loaded_bytes_ptr& buf,
+			const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, int64_t length,
+			const std::vector<int64_t>& pivots, std::vector<int64_t>& node_offsets, ThreadPool& thread_pool, int thr_num)
+		{
+			const int64_t chunk_num = (int64_t)pivots.size() - 1;
+
+			node_offsets.assign(chunk_num + 1, 0);
+
+			thread_pool.ParallelFor(chunk_num, thr_num, [&](int64_t i) {
+				node_offsets[i + 1] = CountNodes(buf, imple, pivots[i], pivots[i + 1], length);
+			});
+
+			for (int64_t i = 0; i < chunk_num; ++i) {
+				node_offsets[i + 1] += node_offsets[i];
+			}
+
+			return node_offsets[chunk_num];
+		}
+
+	private:
+		// a bracket that is not closed in a chunk.
+		struct OpenBracket {
+			int64_t token;
+			int64_t count; // commas in it so far, ( for an array, the index of the element now )
+			char type;
+		};
+
+		// brackets of tokens [begin, end) that do not match in it.
+		struct BracketSummary {
+			std::vector<int64_t> closed; // closers of brackets opened before begin.
+			std::vector<int64_t> below_commas; // commas in the i-th bracket opened before begin ( not closed in it : the last )
+			std::vector<OpenBracket> open; // not closed before end.
+			bool ok = true;
+		};
+
+		static char OpenerOf(char closer) {
+			return closer == '}' ? '{' : '[';
+		}
+
+		// match - not nullptr : brackets matched in [begin, end) get each other`s token.
+		static void SummarizeBrackets(const char* str, const uint32_t* idx, int64_t begin, int64_t end, BracketSummary& summary, uint32_t* match = nullptr) {
+			summary.below_commas.assign(1, 0);
+
+			for (int64_t i = begin; i < end; ++i) {
+				const char c = str[idx[i]];
+				switch (c) {
+				case '{':
+				case '[':
+					summary.open.push_back(OpenBracket{ i, 0, c });
+					break;
+				case '}':
+				case ']':
+					if (!summary.open.empty()) {
+						summary.ok = summary.ok && summary.open.back().type == OpenerOf(c);
+						if (match) {
+							match[summary.open.back().token] = uint32_t(i);
+							match[i] = uint32_t(summary.open.back().token);
+						}
+						summary.open.pop_back();
+					}
+					else {
+						summary.closed.push_back(i);
+						summary.below_commas.push_back(0);
+					}
+					break;
+				case ',':
+					if (!summary.open.empty()) {
+						summary.open.back().count++;
+					}
+					else {
+						summary.below_commas.back()++;
+					}
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		// key token at str[pos] ( '"' ), end : the ':' after it. false : wrong escape.
+		static bool ReadKey(const char* str, uint32_t pos, uint32_t end, std::string& temp, std::string_view& key) {
+			const char* begin = str + pos + 1;
+			const char* quote = static_cast<const char*>(std::memchr(begin, '"', end - pos));
+			if (!quote) {
+				return false;
+			}
+			if (!std::memchr(begin, '\\', quote - begin)) {
+				key = std::string_view(begin, quote - begin);
+				return true;
+			}
+			temp.resize(size_t(end - pos) + SIMDJSON_PADDING);
+			uint8_t* dest = reinterpret_cast<uint8_t*>(&temp[0]);
+			uint8_t* x = simdjson::SIMDJSON_IMPLEMENTATION::stringparsing::parse_string(reinterpret_cast<const uint8_t*>(begin), dest);
+			if (!x) {
+				return false;
+			}
+			key = std::string_view(temp.data(), x - dest);
+			return true;
+		}
+
+		// tokens [begin, end) -> out, only tokens of kept values. stack - brackets open at begin.
+		// the structure of all tokens is checked, skipped strings and numbers are not converted. out == nullptr : only checked.
+		static bool ProjectChunk(const Projection& projection, const char* str, const uint32_t* idx, int64_t begin, int64_t end, bool last,
+			const std::vector<OpenBracket>& stack, std::vector<uint32_t>* out) {
+			enum class Expect { VALUE, FIRST_VALUE, KEY, FIRST_KEY, COLON, AFTER };
+
+			struct Level {
+				char type;
+				const Projection::Node* node; // nullptr : skipped.
+				const Projection::Node* member; // node of the member now.
+				bool member_kept;
+				int64_t count; // array : index of the element now.
+			};
+
+			std::string temp;
+			std::string_view key;
+
+			// levels of the brackets open at begin, from the root.
+			std::vector<Level> levels;
+			for (size_t d = 0; d < stack.size(); ++d) {
+				const Projection::Node* node = projection.get_root();
+				if (d > 0) {
+					const Level& parent = levels[d - 1];
+					if (parent.type == '[') {
+						node = projection.Child(parent.node, parent.count);
+					}
+					else {
+						const int64_t key_token = stack[d].token - 2;
+						if (key_token < 0 || str[idx[key_token]] != '"' || !ReadKey(str, idx[key_token], idx[key_token + 1], temp, key)) {
+							return false;
+						}
+						node = projection.Child(parent.node, key);
+					}
+					levels.back().member = node;
+					levels.back().member_kept = node != nullptr;
+				}
+				levels.push_back(Level{ stack[d].type, node, nullptr, false, stack[d].count });
+			}
+
+			Expect expect = levels.empty() ? Expect::VALUE : (levels.back().type == '{' ? Expect::KEY : Expect::VALUE);
+			int64_t key_token = -1;
+
+			// closes the top bracket, a comma after the last kept member is dropped. ( str is not written, it can be a mapped file )
+			auto close = [&](int64_t i, char c) {
+				if (levels.empty() || levels.back().type != OpenerOf(c)) {
+					return false;
+				}
+				if (out && levels.back().node) {
+					if (!out->empty() && str[out->back()] == ',') {
+						out->pop_back();
+					}
+					out->push_back(idx[i]);
+				}
+				levels.pop_back();
+				expect = Expect::AFTER;
+				return true;
+			};
+
+			for (int64_t i = begin; i < end; ++i) {
+				const char c = str[idx[i]];
+
+				switch (expect) {
+				case Expect::FIRST_KEY:
+				case Expect::KEY:
+					if (c == '}' && expect == Expect::FIRST_KEY) {
+						if (!close(i, c)) {
+							return false;
+						}
+						break;
+					}
+					if (c != '"') {
+						return false;
+					}
+					key_token = i;
+					if (levels.back().node) {
+						if (!ReadKey(str, idx[i], idx[i + 1], temp, key)) {
+							return false;
+						}
+						levels.back().member = projection.Child(levels.back().node, key);
+					}
+					else {
+						levels.back().member = nullptr;
+					}
+					expect = Expect::COLON;
+					break;
+				case Expect::COLON:
+					if (c != ':') {
+						return false;
+					}
+					expect = Expect::VALUE;
+					break;
+				case Expect::FIRST_VALUE:
+				case Expect::VALUE:
+				{
+					if (c == ']' && expect == Expect::FIRST_VALUE) {
+						if (!close(i, c)) {
+							return false;
+						}
+						break;
+					}
+
+					const bool bracket = c == '{' || c == '[';
+					if (!bracket && c != '"' && c != 't' && c != 'f' && c != 'n' && c != '-' && (c < '0' || c > '9')) {
+						return false;
+					}
+
+					const Projection::Node* node = projection.get_root(); // the root value is always kept.
+					bool kept = true;
+					if (!levels.empty()) {
+						Level& top = levels.back();
+						if (top.type == '[') {
+							top.member = projection.Child(top.node, top.count);
+						}
+						node = top.member;
+						kept = node && (node->whole || bracket);
+						top.member_kept = kept;
+
+						if (out && kept && top.type == '{') {
+							out->push_back(idx[key_token]);
+							out->push_back(idx[key_token + 1]);
+						}
+					}
+					if (out && kept) {
+						out->push_back(idx[i]);
+					}
+
+					if (bracket) {
+						levels.push_back(Level{ c, kept ? node : nullptr, nullptr, false, 0 });
+						expect = c == '{' ? Expect::FIRST_KEY : Expect::FIRST_VALUE;
+					}
+					else {
+						expect = Expect::AFTER;
+					}
+				}
+				break;
+				case Expect::AFTER:
+					if (c == ',') {
+						if (levels.empty()) {
+							return false;
+						}
+						Level& top = levels.back();
+						if (out && top.member_kept && top.node) {
+							out->push_back(idx[i]);
+						}
+						top.member_kept = false;
+						if (top.type == '[') {
+							top.count++;
+							expect = Expect::VALUE;
+						}
+						else {
+							expect = Expect::KEY;
+						}
+					}
+					else if ((c == '}' || c == ']') && close(i, c)) {
+						//
+					}
+					else {
+						return false;
+					}
+					break;
+				}
+			}
+
+			// the last chunk ends after the root value.
+			return !last || (expect == Expect::AFTER && levels.empty());
+		}
+	public:
+		// Parser::set_projection - tokens [0, length) -> only the tokens of kept values, in place. ( length is changed )
+		// chunks as in pivots, in parallel : 1. brackets not matched in each chunk, 2. brackets open at the start of each chunk,
+		// 3. check the structure and keep tokens of each chunk.
+		// false : wrong structure. ( skipped strings, numbers, true, false and null are not checked )
+		static bool Project(const Projection& projection, const simdjson::dom::parser::loaded_bytes_ptr& buf, size_t buf_len,
+			const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, int64_t& length,
+			const std::vector<int64_t>& pivots, ThreadPool& thread_pool, int thr_num)
+		{
+			const char* str = buf.get();
+			uint32_t* idx = imple->structural_indexes.get();
+			const int64_t chunk_num = (int64_t)pivots.size() - 1;
+
+			if (length <= 0 || chunk_num <= 0) {
+				return false;
+			}
+
+			std::vector<std::vector<uint32_t>> outs(chunk_num);
+			if (!ProjectChunks(projection, str, idx, pivots, thread_pool, thr_num, &outs)) {
+				return false;
+			}
+
+			int64_t count = 0;
+			for (int64_t i = 0; i < chunk_num; ++i) {
+				const std::vector<uint32_t>& out = outs[i];
+				// a closer after a comma of the chunk before, the comma is dropped.
+				if (!out.empty() && count > 0 && str[idx[count - 1]] == ',' && (str[out[0]] == '}' || str[out[0]] == ']')) {
+					--count;
+				}
+				if (!out.empty()) {
+					std::memcpy(idx + count, out.data(), out.size() * sizeof(uint32_t));
+					count += int64_t(out.size());
+				}
+			}
+
+			length = count;
+			imple->n_structural_indexes = uint32_t(count);
+			idx[count] = uint32_t(buf_len);
+			idx[count + 1] = uint32_t(buf_len);
+			idx[count + 2] = 0;
+
+			return count > 0;
+		}
+	private:
+		// 1. and 2. of Project, then 3. on each chunk, outs == nullptr : only the structure is checked.
+		static bool ProjectChunks(const Projection& projection, const char* str, const uint32_t* idx, const std::vector<int64_t>& pivots,
+			ThreadPool& thread_pool, int thr_num, std::vector<std::vector<uint32_t>>* outs)
+		{
+			const int64_t chunk_num = (int64_t)pivots.size() - 1;
+
+			std::vector<BracketSummary> summaries(chunk_num);
+			thread_pool.ParallelFor(chunk_num, thr_num, [&](int64_t i) {
+				SummarizeBrackets(str, idx, pivots[i], pivots[i + 1], summaries[i]);
+			});
+
+			std::vector<std::vector<OpenBracket>> stacks(chunk_num);
+			{
+				std::vector<OpenBracket> stack;
+				for (int64_t i = 0; i < chunk_num; ++i) {
+					const BracketSummary& summary = summaries[i];
+					if (!summary.ok) {
+						return false;
+					}
+					stacks[i] = stack;
+
+					for (size_t k = 0; k < summary.closed.size(); ++k) {
+						if (stack.empty() || stack.back().type != OpenerOf(str[idx[summary.closed[k]]])) {
+							return false;
 						}
+						stack.pop_back();
+					}
+					if (!stack.empty()) {
+						stack.back().count += summary.below_commas.back();
+					}
+					else if (summary.below_commas.back() > 0) {
+						return false;
+					}
+					stack.insert(stack.end(), summary.open.begin(), summary.open.end());
+				}
+				if (!stack.empty()) {
+					return false;
+				}
+			}
+			summaries.clear();
+
+			std::vector<int> ok(chunk_num, 0);
+			thread_pool.ParallelFor(chunk_num, thr_num, [&](int64_t i) {
+				ok[i] = ProjectChunk(projection, str, idx, pivots[i], pivots[i + 1], i + 1 == chunk_num, stacks[i], outs ? &(*outs)[i] : nullptr);
+			});
+
+			for (int64_t i = 0; i < chunk_num; ++i) {
+				if (!ok[i]) {
+					return false;
+				}
+			}
+			return true;
+		}
+	public:
+		// Parser::set_lazy_subtrees - the structure of tokens [0, length) is checked as in Project, the tokens are not changed.
+		static bool CheckStructure(const simdjson::dom::parser::loaded_bytes_ptr& buf,
+			const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, int64_t length,
+			const std::vector<int64_t>& pivots, ThreadPool& thread_pool, int thr_num)
+		{
+			if (length <= 0 || pivots.size() < 2) {
+				return false;
+			}
+			return ProjectChunks(Projection(), buf.get(), imple->structural_indexes.get(), pivots, thread_pool, thr_num, nullptr);
+		}
+
+		// Parser::set_bracket_index - match[i] : the token of the bracket that matches bracket token i, ( others : 0 )
+		// chunks as in pivots, brackets in a chunk are matched in parallel, the rest in order of chunks.
+		// false : brackets do not match.
+		static bool MatchBrackets(const simdjson::dom::parser::loaded_bytes_ptr& buf,
+			const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, int64_t length,
+			const std::vector<int64_t>& pivots, std::vector<uint32_t>& match, ThreadPool& thread_pool, int thr_num)
+		{
+			const char* str = buf.get();
+			const uint32_t* idx = imple->structural_indexes.get();
+			const int64_t chunk_num = (int64_t)pivots.size() - 1;
+
+			match.assign(size_t(length), 0);
 
+			std::vector<BracketSummary> summaries(chunk_num);
+			thread_pool.ParallelFor(chunk_num, thr_num, [&](int64_t i) {
+				SummarizeBrackets(str, idx, pivots[i], pivots[i + 1], summaries[i], match.data());
+			});
 
-						class UserType* pTemp = nestedUT[braceNum]->get_data_list(nestedUT[braceNum]->get_data_size() - 1);
+			std::vector<OpenBracket> stack;
+			for (const BracketSummary& summary : summaries) {
+				if (!summary.ok) {
+					return false;
+				}
+				for (int64_t closer : summary.closed) {
+					if (stack.empty() || stack.back().type != OpenerOf(str[idx[closer]])) {
+						return false;
+					}
+					match[stack.back().token] = uint32_t(closer);
+					match[closer] = uint32_t(stack.back().token);
+					stack.pop_back();
+				}
+				stack.insert(stack.end(), summary.open.begin(), summary.open.end());
+			}
+			return stack.empty();
+		}
 
-						braceNum++;
+		static bool _LoadData(claujson::UserType* pool, class UserType& global, const simdjson::dom::parser::loaded_bytes_ptr& buf, size_t buf_len,
+			const std::unique_ptr<uint8_t[]>& string_buf,
+			const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, int64_t& length,
+			const std::vector<int64_t>& pivots, const std::vector<int64_t>& node_offsets, std::vector<Block>& blocks, std::vector<StringArena>& arenas,
+			KeyTable* key_table, ThreadPool& thread_pool, int thr_num, LazyInput* lazy) // first, strVec.empty() must be true!!
+		{
+			{
+				std::vector<class UserType*> next(pivots.size() - 1, nullptr);
+				{
 
-						/// new nestedUT
-						if (nestedUT.size() == braceNum) {
-							nestedUT.push_back(nullptr);
+					std::vector<class UserType> __global(pivots.size() - 1);
+					for (int i = 0; i < __global.size(); ++i) {
+						__global[i].type = -2;
+					}
+
+					std::vector<class UserType*> after_pool(pivots.size() - 1, nullptr);
+
+					std::vector<int> err(pivots.size() - 1, 0);
+
+					arenas.clear();
+					arenas.resize(pivots.size() - 1); // one per chunk, a chunk is parsed by one thread.
+
+					std::vector<KeyCache> key_caches(pivots.size() - 1, KeyCache(key_table));
+
+					auto a = std::chrono::steady_clock::now();
+
+					// parse_num can be larger than thr_num, chunks are scheduled with work stealing.
+					thread_pool.ParallelFor(pivots.size() - 1, thr_num, [&](int64_t i) {
+						int64_t _token_arr_len = pivots[i + 1] - pivots[i];
+
+						__LoadData(pool + node_offsets[i], buf, buf_len, string_buf, imple, pivots[i], _token_arr_len, &__global[i], 0, 0,
+							&next[i], &err[i], (int)i, after_pool[i], length, &arenas[i], key_table ? &key_caches[i] : nullptr, lazy);
+					});
+
+					// node_offsets are exact, after_pool[i] == pool + node_offsets[i + 1].
+					for (size_t i = 0; i < pivots.size() - 1; ++i) {
+						if (after_pool[i] && after_pool[i] - pool < node_offsets[i + 1]) {
+							blocks.push_back(Block{ after_pool[i] - pool, node_offsets[i + 1] - (after_pool[i] - pool) });
 						}
+					}
+					auto b = std::chrono::steady_clock::now();
+					auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+					std::cout << "parse1 " << dur.count() << "ms\n";
 
-						/// initial new nestedUT.
-						nestedUT[braceNum] = pTemp;
+					std::vector<UserType*> roots(__global.size());
+					for (size_t i = 0; i < __global.size(); ++i) {
+						roots[i] = &__global[i];
+					}
 
-						state = 0;
+					if (!MergeAll(roots, next, err, global, thread_pool, thr_num)) {
+						return false;
+					}
+
+					auto c = std::chrono::steady_clock::now();
+					auto dur2 = std::chrono::duration_cast<std::chrono::nanoseconds>(c - b);
+					std::cout << "parse2 " << dur2.count() << "ns\n";
+				}
+			}
+
+			/// global = std::move(_global);
+			//int b = clock();
+			//std::cout << "chk " << b - a << "ms\n";
+			return true;
+		}
+		// test - after load_begin(), the file is read here in block_size blocks.
+		// while blocks are read, quotes of read blocks are counted, stage 1 runs on chunks that can be cut,
+		// and __LoadData runs on tokens that are already indexed.
+		// pools[i] has pool_sizes[i] nodes, (even if it fails) arenas - strings of the nodes, one per tree chunk.
+		// key_table - not nullptr : keys are interned.
+		// error - of reading or stage 1, not printed here. ( SUCCESS and false : wrong structure or not enough memory )
+		static bool _LoadDataPipelined(simdjson::dom::parser& test, size_t len, class UserType& global,
+			std::vector<UserType*>& pools, std::vector<int64_t>& pool_sizes, std::vector<Block>& blocks, std::vector<StringArena>& arenas,
+			KeyTable* key_table, size_t block_size, ThreadPool& thread_pool, int thr_num, int64_t& length, simdjson::error_code& error,
+			LazyInput* lazy = nullptr)
+		{
+			struct Stage1Chunk {
+				size_t start = 0;
+				size_t len = 0;
+				simdjson::error_code err = simdjson::error_code::SUCCESS;
+				std::future<void> done;
+			};
+
+			struct CopyChunk {
+				int64_t offset = 0;
+				int64_t num = 0;
+				std::future<void> done;
+			};
+
+			struct TreeChunk {
+				UserType root;
+				UserType* next = nullptr;
+				UserType* pool = nullptr;
+				int64_t pool_size = 0;
+				UserType* after_pool = nullptr;
+				StringArena arena;
+				KeyCache keys;
+				int64_t token_arr_start = 0;
+				int64_t token_arr_len = 0;
+				int err = 0;
+				std::future<void> done;
+			};
+
+			const auto& buf = test.raw_buf();
+			const auto& string_buf = test.raw_string_buf();
+			const auto& imple = test.raw_implementation();
+			const uint8_t* ubuf = reinterpret_cast<const uint8_t*>(buf.get());
+
+			error = simdjson::error_code::SUCCESS;
+
+			const size_t block_num = (len + block_size - 1) / block_size;
+
+			test.reserve_stage1_chunks(block_num);
+
+			std::vector<uint8_t> quote_odd(block_num, 0);
+			std::vector<std::future<void>> quote_done(block_num);
+
+			// deque - pointers to elements are kept while adding.
+			std::deque<Stage1Chunk> stage1_chunks;
+			std::deque<CopyChunk> copy_chunks;
+			std::deque<TreeChunk> tree_chunks;
+
+			bool fail = false;
 
+			size_t copy_idx = 0; // next stage 1 chunk to copy.
+			size_t copy_wait_idx = 0; // next copy to wait.
+			int64_t copied = 0; // tokens given to copy.
+			int64_t available = 0; // tokens in imple->structural_indexes.
+			int64_t tree_start = 0;
+			std::deque<int64_t> pivots;
+
+			// escaped by odd number of backslashes before x?
+			auto is_escaped = [ubuf](size_t x) {
+				bool escaped = false;
+				for (; x > 0 && ubuf[x - 1] == '\\'; --x) {
+					escaped = !escaped;
+				}
+				return escaped;
+			};
+
+			auto launch_stage1 = [&](size_t start, size_t end) {
+				const size_t idx = stage1_chunks.size();
+				stage1_chunks.emplace_back();
+				Stage1Chunk* chunk = &stage1_chunks.back();
+				chunk->start = start;
+				chunk->len = end - start;
+				chunk->done = thread_pool.Enqueue([&test, ubuf, chunk, idx]() {
+					chunk->err = test.stage1_chunk(idx, ubuf, chunk->start, chunk->len);
+				});
+			};
+
+			auto launch_tree = [&](int64_t start, int64_t end, int64_t token_num) {
+				const int no = (int)tree_chunks.size();
+				tree_chunks.emplace_back();
+				TreeChunk* chunk = &tree_chunks.back();
+				chunk->root.type = -2;
+				chunk->keys = KeyCache(key_table);
+				chunk->token_arr_start = start;
+				chunk->token_arr_len = end - start;
+				chunk->done = thread_pool.Enqueue([&test, &buf, &string_buf, &imple, len, chunk, no, token_num, key_table, lazy]() {
+					// exact size, counted here not to slow down the reading thread.
+					chunk->pool_size = CountNodes(buf, imple, chunk->token_arr_start, chunk->token_arr_start + chunk->token_arr_len, token_num);
+					chunk->pool = NewPool(chunk->pool_size, test.huge_pages());
+					if (!chunk->pool) {
+						return;
+					}
+					// in err, not thrown, the futures are waited one by one and the other tasks use local variables.
+					try {
+						__LoadData(chunk->pool, buf, len, string_buf, imple, chunk->token_arr_start, chunk->token_arr_len, &chunk->root, 0, 0,
+							&chunk->next, &chunk->err, no, chunk->after_pool, token_num, &chunk->arena, key_table ? &chunk->keys : nullptr, lazy);
+					}
+					catch (const std::bad_alloc&) {
+						chunk->err = -5;
+					}
+				});
+			};
+
+			auto is_ready = [](std::future<void>& x) {
+				return x.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+			};
+
+			// wait - true : until all launched stage 1 chunks are copied.
+			auto progress = [&](bool wait) {
+				// 1. stage 1 done -> copy to imple->structural_indexes.
+				while (!fail && copy_idx < stage1_chunks.size() && (wait || is_ready(stage1_chunks[copy_idx].done))) {
+					Stage1Chunk& chunk = stage1_chunks[copy_idx];
+					chunk.done.get();
+					if (chunk.err != simdjson::error_code::SUCCESS) {
+						error = chunk.err;
+						fail = true;
+						break;
 					}
-					// Right 2
-					else if (type == simdjson::internal::tape_type::END_OBJECT ||
-						type == simdjson::internal::tape_type::END_ARRAY) {
 
-						if (type == simdjson::internal::tape_type::END_ARRAY && nestedUT[braceNum]->is_object()) {
-							std::cout << "{]";
-							exit(1);
+					const auto& chunk_imple = test.raw_chunk_implementation(copy_idx);
+
+					copy_chunks.emplace_back();
+					CopyChunk* copy = &copy_chunks.back();
+					copy->offset = copied;
+					copy->num = chunk_imple && chunk.len > 0 ? chunk_imple->n_structural_indexes : 0;
+					copied += copy->num;
+
+					const uint32_t base = uint32_t(chunk.start);
+					copy->done = thread_pool.Enqueue([&imple, &chunk_imple, copy, base]() {
+						uint32_t* dst = imple->structural_indexes.get() + copy->offset;
+						for (int64_t k = 0; k < copy->num; ++k) {
+							dst[k] = chunk_imple->structural_indexes[k] + base;
 						}
-						
-						if (type == simdjson::internal::tape_type::END_OBJECT && nestedUT[braceNum]->is_array()) {
-							std::cout << "[}";
-							exit(1);
+					});
+					++copy_idx;
+				}
+
+				// 2. copied -> find division places, give tokens to __LoadData.
+				while (!fail && copy_wait_idx < copy_chunks.size() && (wait || is_ready(copy_chunks[copy_wait_idx].done))) {
+					CopyChunk& copy = copy_chunks[copy_wait_idx];
+					copy.done.get();
+					available = copy.offset + copy.num;
+					++copy_wait_idx;
+
+					if (copy.num > 0) {
+						int64_t pivot = FindDivisionPlace(buf, imple, copy.offset, available - 1);
+						if (pivot != -1 && pivot > tree_start && (pivots.empty() || pivot > pivots.back())) {
+							pivots.push_back(pivot);
 						}
+					}
 
-						state = 0;
+					// __LoadData can look at the next two tokens.
+					while (!fail && !pivots.empty() && pivots.front() + 2 <= available) {
+						launch_tree(tree_start, pivots.front(), available);
+						tree_start = pivots.front();
+						pivots.pop_front();
+					}
+				}
+			};
+
+			// read.
+			bool in_string = false; // at the start of block k.
+			size_t stage1_start = 0;
+
+			for (size_t k = 0; k < block_num && !fail; ++k) {
+				size_t n = 0;
+				error = test.load_next(block_size).get(n);
+				if (error || n == 0) {
+					if (!error) { // the file is shorter than at load_begin.
+						error = simdjson::error_code::IO_ERROR;
+					}
+					fail = true;
+					break;
+				}
+
+				const size_t block_start = k * block_size;
+
+				quote_done[k] = thread_pool.Enqueue([&quote_odd, &is_escaped, ubuf, k, block_start, n]() {
+					quote_odd[k] = uint8_t(simdjson::dom::parser::count_unescaped_quotes(ubuf + block_start, n, is_escaped(block_start)) & 1);
+				});
+
+				if (k >= 1) {
+					quote_done[k - 1].get();
+					in_string = in_string ^ (quote_odd[k - 1] != 0);
+
+					const size_t cut = simdjson::dom::parser::find_stage1_split(ubuf, block_start, block_start + n, in_string, is_escaped(block_start));
+					if (cut <= block_start + n) {
+						launch_stage1(stage1_start, cut);
+						stage1_start = cut;
+					}
+				}
+
+				progress(false);
+			}
+
+			if (!fail) {
+				launch_stage1(stage1_start, len);
+				progress(true);
+			}
+
+			if (!fail) {
+				length = copied;
+
+				if (length == 0) {
+					error = simdjson::error_code::EMPTY;
+					fail = true;
+				}
+				else {
+					imple->n_structural_indexes = uint32_t(length);
+					imple->structural_indexes[length] = uint32_t(len);
+					imple->structural_indexes[length + 1] = uint32_t(len);
+					imple->structural_indexes[length + 2] = 0;
+					imple->next_structural_index = 0;
+
+					for (; !fail && !pivots.empty(); pivots.pop_front()) {
+						launch_tree(tree_start, pivots.front(), length);
+						tree_start = pivots.front();
+					}
+					if (!fail && tree_start < length) {
+						launch_tree(tree_start, length, length);
+					}
+				}
+			}
+
+			// wait all, tasks use local variables.
+			for (auto& x : quote_done) {
+				if (x.valid()) {
+					x.get();
+				}
+			}
+			for (auto& x : stage1_chunks) {
+				if (x.done.valid()) {
+					x.done.get();
+				}
+			}
+			for (auto& x : copy_chunks) {
+				if (x.done.valid()) {
+					x.done.get();
+				}
+			}
+			for (auto& x : tree_chunks) {
+				if (x.done.valid()) {
+					x.done.get();
+				}
+				if (x.pool) {
+					pools.push_back(x.pool);
+					pool_sizes.push_back(x.pool_size);
+					arenas.push_back(std::move(x.arena));
+				}
+				else {
+					fail = true;
+				}
+			}
+
+			if (fail) {
+				return false;
+			}
+
+			std::vector<UserType*> roots(tree_chunks.size());
+			std::vector<UserType*> next(tree_chunks.size());
+			std::vector<int> err(tree_chunks.size());
+
+			for (size_t i = 0; i < tree_chunks.size(); ++i) {
+				TreeChunk& chunk = tree_chunks[i];
+
+				roots[i] = &chunk.root;
+				next[i] = chunk.next;
+				err[i] = chunk.err;
+
+				// pool_size is exact, no free block normally.
+				if (chunk.after_pool && chunk.after_pool - chunk.pool < chunk.pool_size) {
+					blocks.push_back(Block{ chunk.after_pool - chunk.pool, chunk.pool_size - (chunk.after_pool - chunk.pool), chunk.pool });
+				}
+			}
 
-						if (!Vec.empty()) {
-							if (type == simdjson::internal::tape_type::END_OBJECT) {
-								nestedUT[braceNum]->reserve_data_list(nestedUT[braceNum]->get_data_size() + Vec.size() / 2);
+			return MergeAll(roots, next, err, global, thread_pool, thr_num);
+		}
+
+		static bool parse(claujson::UserType* pool, class UserType& global, const simdjson::dom::parser::loaded_bytes_ptr& buf, size_t buf_len,
+				const std::unique_ptr<uint8_t[]>& string_buf,
+				const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple,
+				int64_t length, const std::vector<int64_t>& pivots, const std::vector<int64_t>& node_offsets, std::vector<Block>& blocks, std::vector<StringArena>& arenas,
+				KeyTable* key_table, ThreadPool& thread_pool, int thr_num, LazyInput* lazy = nullptr) {
+
+			return LoadData::_LoadData(pool, global, buf, buf_len, string_buf, imple, length, pivots, node_offsets, blocks, arenas, key_table, thread_pool, thr_num, lazy);
+		}
+
+		//
+		static void _save(std::ostream& stream, UserType* ut, const int depth = 0) {
+			if (!ut) { return; }
+
+			if (ut->is_object()) {
+				for (size_t i = 0; i < ut->get_data_size(); ++i) {
+					if (ut->get_data_list(i)->is_user_type()) {
+						auto& x = ut->get_data_list(i)->get_value();
 
+						if (
+							x.key.type == simdjson::internal::tape_type::STRING) {
+							stream << "\"";
+							for (long long j = 0; j < x.key.get_str_val().size(); ++j) {
+								switch (x.key.get_str_val()[j]) {
+								case '\\':
+									stream << "\\\\";
+									break;
+								case '\"':
+									stream << "\\\"";
+									break;
+								case '\n':
+									stream << "\\n";
+									break;
 
-								if (Vec.size() % 2 == 1) {
-									exit(1);
+								default:
+									if (isprint(x.key.get_str_val()[j]))
+									{
+										stream << x.key.get_str_val()[j];
+									}
+									else
+									{
+										int code = x.key.get_str_val()[j];
+										if (code > 0 && (code < 0x20 || code == 0x7F))
+										{
+											char buf[] = "\\uDDDD";
+											sprintf(buf + 2, "%04X", code);
+											stream << buf;
+										}
+										else {
+											stream << x.key.get_str_val()[j];
+										}
+									}
 								}
+							}
+
+							stream << "\"";
+
+							if (x.key.is_key) {
+								stream << " : ";
+							}
+						}
+						else {
+							std::cout << "Error : no key\n";
+						}
+						stream << " ";
+
+						if (((UserType*)ut->get_data_list(i))->is_object()) {
+							stream << " { \n";
+						}
+						else {
+							stream << " [ \n";
+						}
+
+						_save(stream, (UserType*)ut->get_data_list(i), depth + 1);
+
+						if (((UserType*)ut->get_data_list(i))->is_object()) {
+							stream << " } \n";
+						}
+						else {
+							stream << " ] \n";
+						}
+					}
+					else {
+						auto& x = ut->get_data_list(i)->get_value();
 
+						if (
+							x.key.type == simdjson::internal::tape_type::STRING) {
+							stream << "\"";
+							for (long long j = 0; j < x.key.get_str_val().size(); ++j) {
+								switch (x.key.get_str_val()[j]) {
+								case '\\':
+									stream << "\\\\";
+									break;
+								case '\"':
+									stream << "\\\"";
+									break;
+								case '\n':
+									stream << "\\n";
+									break;
 
-								for (size_t x = 0; x < Vec.size(); x += 2) {
-									if (!Vec[x].is_key) {
-										exit(1);
+								default:
+									if (isprint(x.key.get_str_val()[j]))
+									{
+										stream << x.key.get_str_val()[j];
+									}
+									else
+									{
+										int code = x.key.get_str_val()[j];
+										if (code > 0 && (code < 0x20 || code == 0x7F))
+										{
+											char buf[] = "\\uDDDD";
+											sprintf(buf + 2, "%04X", code);
+											stream << buf;
+										}
+										else {
+											stream << x.key.get_str_val()[j];
+										}
 									}
-									if (Vec[x + 1].is_key) {
-										exit(1);
+								}
+							}
+
+							stream << "\"";
+
+							if (x.key.is_key) {
+								stream << " : ";
+							}
+						}
+
+						{
+							auto& x = ut->get_data_list(i)->get_value();
+
+							if (
+								x.data.type == simdjson::internal::tape_type::STRING) {
+								stream << "\"";
+								for (long long j = 0; j < x.data.get_str_val().size(); ++j) {
+									switch (x.data.get_str_val()[j]) {
+									case '\\':
+										stream << "\\\\";
+										break;
+									case '\"':
+										stream << "\\\"";
+										break;
+									case '\n':
+										stream << "\\n";
+										break;
+
+									default:
+										if (isprint(x.data.get_str_val()[j]))
+										{
+											stream << x.data.get_str_val()[j];
+										}
+										else
+										{
+											int code = x.data.get_str_val()[j];
+											if (code > 0 && (code < 0x20 || code == 0x7F))
+											{
+												char buf[] = "\\uDDDD";
+												sprintf(buf + 2, "%04X", code);
+												stream << buf;
+											}
+											else {
+												stream << x.data.get_str_val()[j];
+											}
+										}
 									}
-
-									nestedUT[braceNum]->add_item_type(pool, Vec[x].idx, Vec[x].idx2, Vec[x].len,
-										Vec[x+1].idx, Vec[x+1].idx2, Vec[x+1].len, buf, string_buf, Vec[x].id, Vec[x + 1].id);
-									++pool;
-
 								}
-							}
-							else { // END_ARRAY
-								nestedUT[braceNum]->reserve_data_list(nestedUT[braceNum]->get_data_size() + Vec.size());
 
-								for (size_t x = 0; x < Vec.size(); x += 1) {
-									if (Vec[x].is_key) {
-										exit(1);
-									}
+								stream << "\"";
 
-									nestedUT[braceNum]->add_item_type(pool, (Vec[x].idx), Vec[x].idx2, Vec[x].len, buf, string_buf, Vec[x].id);
-									++pool;
-								}
 							}
-
-							Vec.clear();
+							else if (x.data.type == simdjson::internal::tape_type::TRUE_VALUE) {
+								stream << "true";
+							}
+							else if (x.data.type == simdjson::internal::tape_type::FALSE_VALUE) {
+								stream << "false";
+							}
+							else if (x.data.type == simdjson::internal::tape_type::DOUBLE) {
+								stream << std::fixed << std::setprecision(6) << (x.data.float_val);
+							}
+							else if (x.data.type == simdjson::internal::tape_type::INT64) {
+								stream << x.data.int_val;
+							}
+							else if (x.data.type == simdjson::internal::tape_type::UINT64) {
+								stream << x.data.uint_val;
+							}
+							else if (x.data.type == simdjson::internal::tape_type::NULL_VALUE) {
+								stream << "null ";
+							}
 						}
+					}
 
+					if (i < ut->get_data_size() - 1) {
+						stream << ", ";
+					}
+				}
+			}
+			else if (ut->is_array()) {
+				for (size_t i = 0; i < ut->get_data_size(); ++i) {
+					if (ut->get_data_list(i)->is_user_type()) {
 
-						if (braceNum == 0) {
-							class UserType ut; //
-
-							ut.add_user_type(pool, type == simdjson::internal::tape_type::END_OBJECT ? 2 : 3); // json -> "var_name" = val  
-							++pool;
 
-							for (size_t i = 0; i < nestedUT[braceNum]->get_data_size(); ++i) {
-								ut.get_data_list(0)->add_user_type(nestedUT[braceNum]->get_data_list(i));
-								nestedUT[braceNum]->get_data_list(i) = nullptr;
-							}
+						if (((UserType*)ut->get_data_list(i))->is_object()) {
+							stream << " { \n";
+						}
+						else {
+							stream << " [ \n";
+						}
 
-							nestedUT[braceNum]->remove_all();
-							nestedUT[braceNum]->add_user_type(ut.get_data_list(0));
 
-							ut.get_data_list(0) = nullptr;
+						_save(stream, (UserType*)ut->get_data_list(i), depth + 1);
 
-							braceNum++;
+						if (((UserType*)ut->get_data_list(i))->is_object()) {
+							stream << " } \n";
 						}
-
-						{
-							if (braceNum < nestedUT.size()) {
-								nestedUT[braceNum] = nullptr;
-							}
-
-							braceNum--;
+						else {
+							stream << " ] \n";
 						}
 					}
 					else {
-						{
-							Test data;
-
-							data.idx = imple->structural_indexes[token_arr_start + i];
-							data.id = token_arr_start + i;
-
-							if (token_arr_start + i + 1 < imple->n_structural_indexes) {
-								data.idx2 = imple->structural_indexes[token_arr_start + i + 1];
-							}
-							else {
-								data.idx2 = buf_len;
-							}
 
-							bool is_key = false;
-							if (token_arr_start + i + 1 < imple->n_structural_indexes && buf[imple->structural_indexes[token_arr_start + i + 1]] == ':') {
-								is_key = true;
-							}
+						auto& x = ut->get_data_list(i)->get_value();
 
-							if (is_key) {
-								data.is_key = true;
-							
-								if (token_arr_start + i + 2 < imple->n_structural_indexes) {
-									const simdjson::internal::tape_type _type = (simdjson::internal::tape_type)buf[imple->structural_indexes[token_arr_start + i + 2]];
+						if (
+							x.data.type == simdjson::internal::tape_type::STRING) {
+							stream << "\"";
+							for (long long j = 0; j < x.data.get_str_val().size(); ++j) {
+								switch (x.data.get_str_val()[j]) {
+								case '\\':
+									stream << "\\\\";
+									break;
+								case '\"':
+									stream << "\\\"";
+									break;
+								case '\n':
+									stream << "\\n";
+									break;
 
-									if (_type == simdjson::internal::tape_type::START_ARRAY || _type == simdjson::internal::tape_type::START_OBJECT) {
-										key = std::move(data); 
+								default:
+									if (isprint(x.data.get_str_val()[j]))
+									{
+										stream << x.data.get_str_val()[j];
 									}
-									else {
-										Vec.push_back(std::move(data)); 
+									else
+									{
+										int code = x.data.get_str_val()[j];
+										if (code > 0 && (code < 0x20 || code == 0x7F))
+										{
+											char buf[] = "\\uDDDD";
+											sprintf(buf + 2, "%04X", code);
+											stream << buf;
+										}
+										else {
+											stream << x.data.get_str_val()[j];
+										}
 									}
 								}
-								else {
-									Vec.push_back(std::move(data));
-								}
-								++i;
-									
-								is_now_comma = false;
-							}
-							else {	
-								Vec.push_back(std::move(data));
 							}
 
-							state = 0;
+							stream << "\"";
 						}
-					}
-				
-				}
-				break;
-				default:
-					// syntax err!!
-					*err = -1;
-					return false; // throw "syntax error ";
-					break;
-				}
-			}
-
-			if (next) {
-				*next = nestedUT[braceNum];
-			}
-
-			if (Vec.empty() == false) {
-				if (Vec[0].is_key) {
-					for (size_t x = 0; x < Vec.size(); x += 2) {
-						if (!Vec[x].is_key) {
-							exit(1);
+						else if (x.data.type == simdjson::internal::tape_type::TRUE_VALUE) {
+							stream << "true";
 						}
-
-						if (Vec.size() % 2 == 1) {
-							exit(1);
+						else if (x.data.type == simdjson::internal::tape_type::FALSE_VALUE) {
+							stream << "false";
+						}
+						else if (x.data.type == simdjson::internal::tape_type::DOUBLE) {
+							stream << std::fixed << std::setprecision(6) << (x.data.float_val);
+						}
+						else if (x.data.type == simdjson::internal::tape_type::INT64) {
+							stream << x.data.int_val;
+						}
+						else if (x.data.type == simdjson::internal::tape_type::UINT64) {
+							stream << x.data.uint_val;
+						}
+						else if (x.data.type == simdjson::internal::tape_type::NULL_VALUE) {
+							stream << "null ";
 						}
 
 
-						if (Vec[x + 1].is_key) {
-							exit(1);
-						}
+						stream << " ";
+					}
 
-						nestedUT[braceNum]->add_item_type(pool, Vec[x].idx, Vec[x].idx2, Vec[x].len, Vec[x +1].idx,Vec[x+1].idx2, Vec[x+1].len, 
-							buf, string_buf, Vec[x].id, Vec[x + 1].id);
-						++pool;
+					if (i < ut->get_data_size() - 1) {
+						stream << ", ";
 					}
 				}
-				else {
-					for (size_t x = 0; x < Vec.size(); x += 1) {
-						if (Vec[x].is_key) {
-							exit(1);
-						}
+			}
+		}
 
-						nestedUT[braceNum]->add_item_type(pool, Vec[x].idx, Vec[x].idx2, Vec[x].len, buf, string_buf, Vec[x].id);
-						++pool;
+		// copy of the tree of root ( root is only read ), in pool, nodes in order. strings and child lists in arena.
+		//   interned keys are interned again in key_table, it is made if needed.
+		static bool _Compact(const UserType* root, UserType* out, UserType*& pool, int64_t& pool_size, StringArena& arena,
+			std::unique_ptr<KeyTable>& key_table, NodeOrder order) {
+			// 1. count nodes.
+			int64_t node_num = 0;
+			{
+				std::vector<const UserType*> stack{ root };
+				while (!stack.empty()) {
+					const UserType* x = stack.back();
+					stack.pop_back();
+					x->Expand();
+					node_num += x->list().size();
+					for (const UserType* y : x->list()) {
+						stack.push_back(y);
 					}
 				}
-
-				Vec.clear();
 			}
 
-			if (state != last_state) {
-				*err = -2;
+			pool = NewPool(node_num);
+			if (!pool) {
 				return false;
-				// throw STRING("error final state is not last_state!  : ") + toStr(state);
+			}
+			pool_size = node_num;
+
+			// 2. copy, a node is placed when it is visited. ( DFS : stack, BFS : queue )
+			struct Work {
+				const UserType* from;
+				UserType** slot; // in the child list of parent.
+				UserType* parent;
+			};
+			std::vector<Work> work;
+			size_t head = 0;
+
+			auto link = [&](const UserType* from, UserType* to) {
+				const size_t n = from->list().size();
+				if (n == 0) {
+					return;
+				}
+				UserType** arr = (UserType**)arena.Alloc(n * sizeof(UserType*));
+				to->make_list(&arena).Adopt(arr, n);
+				if (order == NodeOrder::DFS) {
+					for (size_t i = n; i > 0; --i) {
+						work.push_back(Work{ from->list()[i - 1], arr + i - 1, to });
+					}
+				}
+				else {
+					for (size_t i = 0; i < n; ++i) {
+						work.push_back(Work{ from->list()[i], arr + i, to });
+					}
+				}
+			};
+
+			*out = UserType();
+			CopyValue(out, root, arena, key_table);
+			link(root, out);
+
+			int64_t next = 0;
+			while (head < work.size()) {
+				Work w;
+				if (order == NodeOrder::BFS) {
+					w = work[head];
+					++head;
+				}
+				else {
+					w = work.back();
+					work.pop_back();
+				}
+
+				UserType* x = pool + next;
+				++next;
+				new (x) UserType();
+				x->alloc_type = PoolManager::Type::FROM_POOL;
+				CopyValue(x, w.from, arena, key_table);
+				x->parent = w.parent;
+				*w.slot = x;
+
+				link(w.from, x);
 			}
 
-			after_pool = pool;
-			//int b = clock();
-			//std::cout << "parse thread " << b - a << "ms\n";
 			return true;
 		}
 
-		static int64_t FindDivisionPlace(const std::unique_ptr<char[]>& buf, const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, int64_t start, int64_t last)
-		{
-			for (int64_t a = start; a <= last; ++a) {
-				auto& x = imple->structural_indexes[a]; //  token_arr[a];
-				const simdjson::internal::tape_type type = (simdjson::internal::tape_type)buf[x];
-				bool key = false;
-				bool next_is_valid = false;
+		// root <- out, ( root of a copy from _Compact )
+		static void MoveRoot(UserType* root, UserType* out) {
+			*root = std::move(*out);
+			for (UserType* x : root->list()) {
+				x->parent = root;
+			}
+		}
+	private:
+		static void CopyValue(UserType* to, const UserType* from, StringArena& arena, std::unique_ptr<KeyTable>& key_table) {
+			const ItemType& value = from->get_value(); // lazy -> decoded.
+			CopyData(to->value.key, value.key, arena, key_table);
+			CopyData(to->value.data, value.data, arena, key_table);
+			to->type = from->type;
+			if (from->is_auto_index()) {
+				to->get_box(&arena).auto_index = true;
+			}
+		}
 
-				switch ((int)type) {
-				case ',':
-					return a + 1;
-				default:
-					// error?
-					break;
+		static void CopyData(Data& to, const Data& from, StringArena& arena, std::unique_ptr<KeyTable>& key_table) {
+			const bool is_str = from.type == simdjson::internal::tape_type::STRING || from.type == simdjson::internal::tape_type::KEY;
+			if (is_str && from.str_val) {
+				std::string_view str = from.get_str_val();
+				if (from.is_interned()) {
+					if (!key_table) {
+						key_table.reset(new KeyTable());
+					}
+					to.set_interned_str_val(key_table->Intern(str));
+				}
+				else {
+					to.set_arena_str_val(arena.Copy(str.data(), str.size()));
 				}
 			}
-			return -1;
+			else if (!is_str) {
+				to.uint_val = from.uint_val;
+			}
+			to.type = from.type;
+			to.is_key = from.is_key;
 		}
 	public:
+		static void save(const std::string& fileName, class UserType& global) {
+			std::ofstream outFile;
+			outFile.open(fileName, std::ios::binary); // binary!
 
-		static bool _LoadData(claujson::UserType* pool, class UserType& global, const std::unique_ptr<char[]>& buf, size_t buf_len,
-			const std::unique_ptr<uint8_t[]>& string_buf,
-			const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple, int64_t& length,
-			std::vector<int64_t>& start, const int parse_num, std::vector<Block>& blocks) // first, strVec.empty() must be true!!
-		{
-			const int pivot_num = parse_num - 1;
-			//size_t token_arr_len = length; // size?
+			_save(outFile, &global);
 
-			class UserType* before_next = nullptr;
-			class UserType _global;
+			outFile.close();
+		}
+	};
 
-			bool first = true;
-			int64_t sum = 0;
+	// read size for ParsePipelined.
+	static const size_t PIPELINE_BLOCK_SIZE = 16 * 1024 * 1024;
 
-			{
-				std::set<int64_t> _pivots;
-				std::vector<int64_t> pivots;
-				//const int64_t num = token_arr_len; //
+	// walks the tokens of the last document of a Parser, without nodes. a container is skipped in O(1) with the bracket index.
+	//   from Parser::get_cursor, valid until the next parse or Clear of the Parser. one thread per Cursor. ( copies are fine )
+	//   it is at a value, the key of an object member is before it.
+	//   ex) Cursor x = parser.get_cursor(); if (x.find("features")) { size_t n = x.size(); ... }
+	class Cursor {
+	private:
+		const simdjson::dom::parser::loaded_bytes_ptr* buf = nullptr;
+		const std::unique_ptr<uint8_t[]>* string_buf = nullptr;
+		const uint32_t* idx = nullptr;
+		const uint32_t* match = nullptr; // Parser`s bracket index.
+		int64_t length = 0; // tokens.
+
+		int64_t token = 0; // the value now.
+		std::vector<int64_t> parents; // containers it is in, from the root.
+
+		StringArena arena; // for get_key and get_value.
+	public:
+		Cursor() { }
+
+		Cursor(const simdjson::dom::parser::loaded_bytes_ptr& buf, const std::unique_ptr<uint8_t[]>& string_buf,
+			const uint32_t* idx, const uint32_t* match, int64_t length)
+			: buf(&buf), string_buf(&string_buf), idx(idx), match(match), length(length) {
+			//
+		}
+
+		Cursor(const Cursor& other)
+			: buf(other.buf), string_buf(other.string_buf), idx(other.idx), match(other.match), length(other.length),
+			token(other.token), parents(other.parents) {
+			//
+		}
+
+		Cursor& operator=(const Cursor& other) {
+			if (this != &other) {
+				buf = other.buf;
+				string_buf = other.string_buf;
+				idx = other.idx;
+				match = other.match;
+				length = other.length;
+				token = other.token;
+				parents = other.parents;
+			}
+			return *this;
+		}
+
+		// false : no document.
+		bool valid() const {
+			return buf && token < length;
+		}
+
+		// index in the structural indexes.
+		int64_t get_token() const {
+			return token;
+		}
+
+		// the last token of the value, the closer of a container.
+		int64_t get_end() const {
+			return is_container() ? int64_t(match[token]) : token;
+		}
 
-				if (pivot_num > 0) {
-					std::vector<int64_t> pivot;
-					pivots.reserve(pivot_num);
-					pivot.reserve(pivot_num);
+		size_t get_depth() const {
+			return parents.size();
+		}
+
+		// { [ " t f n - 0-9
+		char get_char() const {
+			return buf->get()[idx[token]];
+		}
+
+		bool is_object() const {
+			return get_char() == '{';
+		}
+
+		bool is_array() const {
+			return get_char() == '[';
+		}
 
-					pivot.push_back(start[0]);
+		bool is_container() const {
+			const char c = get_char();
+			return c == '{' || c == '[';
+		}
 
-					for (int i = 1; i < parse_num; ++i) {
-						pivot.push_back(FindDivisionPlace(buf, imple, start[i], start[i + 1] - 1));
-					}
+		// a member of an object.
+		bool has_key() const {
+			return !parents.empty() && buf->get()[idx[parents.back()]] == '{';
+		}
 
-					for (size_t i = 0; i < pivot.size(); ++i) {
-						if (pivot[i] != -1) {
-							_pivots.insert(pivot[i]);
-						}
-					}
+		// converted key, has_key() must be true.
+		Data get_key() {
+			return Get(token - 2, true);
+		}
 
-					for (auto& x : _pivots) {
-						pivots.push_back(x);
-					}
+		bool key_equal(std::string_view key) const {
+			if (!has_key()) {
+				return false;
+			}
+			std::string temp;
+			std::string_view x;
+			return LoadData::ReadKey(buf->get(), idx[token - 2], idx[token - 1], temp, x) && x == key;
+		}
 
-					pivots.push_back(length);
-				}
-				else {
-					pivots.push_back(start[0]);
-					pivots.push_back(length);
-				}
+		// converted value, ( STRING, INT64, UINT64, DOUBLE, TRUE_VALUE, FALSE_VALUE, NULL_VALUE ) for a container : an empty Data.
+		Data get_value() {
+			if (is_container()) {
+				return Data();
+			}
+			return Get(token, false);
+		}
 
-				std::vector<class UserType*> next(pivots.size() - 1, nullptr);
-				{
+		// to the first child. false : not a container or empty. ( and it does not move )
+		bool down() {
+			if (!is_container() || match[token] == token + 1) {
+				return false;
+			}
+			parents.push_back(token);
+			token = FirstValue(token, token + 1);
+			return true;
+		}
 
-					std::vector<class UserType> __global(pivots.size() - 1);
-					for (int i = 0; i < __global.size(); ++i) {
-						__global[i].type = -2;
-					}
+		// to the next sibling, over the value now. false : the last one.
+		bool next() {
+			if (parents.empty()) {
+				return false;
+			}
+			const int64_t after = get_end() + 1;
+			if (buf->get()[idx[after]] != ',') {
+				return false;
+			}
+			token = FirstValue(parents.back(), after + 1);
+			return true;
+		}
 
-					std::vector<std::thread> thr(pivots.size() - 1);
+		// to the container it is in. false : at the root.
+		bool up() {
+			if (parents.empty()) {
+				return false;
+			}
+			token = parents.back();
+			parents.pop_back();
+			return true;
+		}
 
-					std::vector<class UserType*> after_pool(pivots.size() - 1, nullptr);
+		// the number of children, O(children).
+		size_t size() const {
+			if (!is_container() || match[token] == token + 1) {
+				return 0;
+			}
+			size_t count = 1;
+			for (int64_t x = FirstValue(token, token + 1); ; ++count) {
+				const int64_t after = (IsBracket(x) ? int64_t(match[x]) : x) + 1;
+				if (buf->get()[idx[after]] != ',') {
+					break;
+				}
+				x = FirstValue(token, after + 1);
+			}
+			return count;
+		}
 
-					std::vector<int> err(pivots.size() - 1, 0);
-					{
-						int64_t idx = pivots[1] - pivots[0];
-						int64_t _token_arr_len = idx;
+		// to the member with key, of this object. false : not found. ( and it does not move )
+		bool find(std::string_view key) {
+			if (!is_object()) {
+				return false;
+			}
+			Cursor x(*this);
+			if (!x.down()) {
+				return false;
+			}
+			do {
+				if (x.key_equal(key)) {
+					token = x.token;
+					parents.push_back(x.parents.back());
+					return true;
+				}
+			} while (x.next());
+			return false;
+		}
 
-						thr[0] = std::thread(__LoadData, pool, std::ref(buf), buf_len, std::ref(string_buf), std::ref(imple), start[0], _token_arr_len, &__global[0], 0, 0,
-							&next[0], &err[0], 0, std::ref(after_pool[0]));
-						//HANDLE th = thr[0].native_handle();
-						//SetThreadPriority(th, THREAD_PRIORITY_HIGHEST);
-					}
+		// to the i-th child, of this container. false : no such child. ( and it does not move )
+		bool at(size_t i) {
+			Cursor x(*this);
+			if (!x.down()) {
+				return false;
+			}
+			for (; i > 0; --i) {
+				if (!x.next()) {
+					return false;
+				}
+			}
+			token = x.token;
+			parents.push_back(x.parents.back());
+			return true;
+		}
+	private:
+		bool IsBracket(int64_t x) const {
+			const char c = buf->get()[idx[x]];
+			return c == '{' || c == '[';
+		}
 
-					for (size_t i = 1; i < pivots.size() - 1; ++i) {
-						int64_t _token_arr_len = pivots[i + 1] - pivots[i];
+		// x : the first token of a child of container, -> its value. ( after the key and : )
+		int64_t FirstValue(int64_t container, int64_t x) const {
+			return buf->get()[idx[container]] == '{' ? x + 2 : x;
+		}
 
-						thr[i] = std::thread(__LoadData, pool, std::ref(buf), buf_len, std::ref(string_buf), std::ref(imple), pivots[i], _token_arr_len, &__global[i], 0, 0,
-							&next[i], &err[i], i, std::ref(after_pool[i]));
+		Data Get(int64_t x, bool key) {
+			Data temp;
+			arena.Clear();
+			simdjson::Convert(temp, idx[x], idx[x + 1], 0, key, *buf, *string_buf, x == 0 ? 0 : 1, &arena);
+			temp.own_str_val(); // out of the arena.
+			return temp;
+		}
+	};
 
-						//HANDLE th = thr[i].native_handle();
-						//SetThreadPriority(th, THREAD_PRIORITY_HIGHEST);
-					}
+	// parse context, owns the simdjson buffers (input, stage 1 indexes), the node pool and the worker threads.
+	// keep one per thread and reuse it, one Parser cannot run two parses at the same time.
+	// the nodes of the last document live in the Parser ( like simdjson::dom::parser`s document ),
+	//   they are valid until the next parse, Clear, Trim or ~Parser, unless Release-d.
+	class Parser {
+	private:
+		simdjson::dom::parser test;
 
+		std::unique_ptr<ThreadPool> own_thread_pool;
+		ThreadPool* thread_pool = nullptr;
+		int thr_num = 1;
 
-					auto a = std::chrono::steady_clock::now();
+		PoolManager manager; // nodes of the last document, destroyed by Clear.
+		std::vector<Block> used; // nodes of the last document made by parse.
+		int64_t doc_pool_size = 0; // 0 : the last document is in pool segments (ParsePipelined)
 
-					// wait
-					for (size_t i = 0; i < thr.size(); ++i) {
-						thr[i].join();
-					}
+		UserType* spare_pool = nullptr; // node pool for the next Parse.
+		int64_t spare_pool_size = 0;
 
-					for (int i = 0; i < pivots.size() - 1; ++i) { // bug fix
-						blocks.push_back(Block{ after_pool[i] - pool, start[i + 1] - (after_pool[i] - pool) });
-					}
+		bool lazy_mode = false;
+		bool doc_lazy = false; // the last document has lazy nodes, they use test`s buffers.
+		LazyInput lazy_input;
 
-					auto b = std::chrono::steady_clock::now();
-					auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
-					std::cout << "parse1 " << dur.count() << "ms\n";
+		bool lazy_subtrees = false;
+		bool doc_subtrees = false; // the last document is made by Expand, its nodes are not all in used.
 
-					for (size_t i = 0; i < err.size(); ++i) {
-						switch (err[i]) {
-						case 0:
-							break;
-						case -1:
-						case -4:
-							std::cout << "Syntax Error\n"; return false;
-							break;
-						case -2:
-							std::cout << "error final state is not last_state!\n"; return false;
-							break;
-						case -3:
-							std::cout << "error x > buffer + buffer_len:\n"; return false;
-							break;
-						default:
-							std::cout << "unknown parser error\n"; return false;
-							break;
-						}
-					}
-
-					// Merge
-					//try
-					{
-						int i = 0;
-						std::vector<int> chk(parse_num, 0);
-						auto x = next.begin();
-						auto y = __global.begin();
-						while (true) {
-							if (y->get_data_size() == 0) {
-								chk[i] = 1;
-							}
+		bool intern_keys = false;
+		std::unique_ptr<KeyTable> key_table; // keys of the last document, if intern_keys.
 
-							++x;
-							++y;
-							++i;
+		MemoryUsage peak_usage;
 
-							if (x == next.end()) {
-								break;
-							}
-						}
+		size_t index_threshold = 0; // 0 : no key indexes.
+		bool eager_index = false;
 
-						int start = 0;
-						int last = pivots.size() - 1 - 1;
+		Projection projection; // empty : the whole document.
 
-						for (int i = 0; i < pivots.size() - 1; ++i) {
-							if (chk[i] == 0) {
-								start = i;
-								break;
-							}
-						}
+		bool bracket_index = false; // Parse builds bracket_match.
+		std::vector<uint32_t> bracket_match; // matching bracket of each bracket token of the last document, empty : not built.
+		int64_t doc_tokens = 0; // tokens of the last document in test, 0 : none. ( for Cursor )
+	public:
+		// own worker threads, thr_num <= 0 : hardware_concurrency.
+		explicit Parser(int thr_num = 0)
+			: own_thread_pool(new ThreadPool(thr_num)) {
+			this->thread_pool = own_thread_pool.get();
+			this->thr_num = (int)thread_pool->size();
+		}
 
-						for (int i = pivots.size() - 1 - 1; i >= 0; --i) {
-							if (chk[i] == 0) {
-								last = i;
-								break;
-							}
-						}
+		// shared worker threads, thr_num <= 0 : thread_pool.size().
+		explicit Parser(ThreadPool& thread_pool, int thr_num = 0)
+			: thread_pool(&thread_pool), thr_num(thr_num) {
+			if (this->thr_num <= 0) {
+				this->thr_num = (int)thread_pool.size();
+			}
+			if (this->thr_num <= 0) {
+				this->thr_num = 1;
+			}
+		}
 
-						if (__global[start].get_data_size() > 0 && __global[start].get_data_list(0)->is_user_type()
-							&& ((UserType*)__global[start].get_data_list(0))->is_virtual()) {
-							std::cout << "not valid file1\n";
-							throw 1;
-						}
-						if (next[last] && next[last]->get_parent() != nullptr) {
-							std::cout << "not valid file2\n";
-							throw 2;
-						}
+		Parser(const Parser&) = delete;
+		Parser& operator=(const Parser&) = delete;
 
+		~Parser() {
+			Clear();
+			if (spare_pool) {
+				FreePool(spare_pool);
+			}
+		}
 
+		// ut gets the document, chunk_per_thread - > 1 : cut into thr_num * chunk_per_thread chunks, and idle threads steal chunks.
+		// return : { success?, the number of tokens }
+		inline std::pair<bool, size_t> Parse(const std::string& fileName, UserType* ut, int chunk_per_thread = 1);
 
-						int err = Merge(&_global, &__global[start], &next[start]);
-						if (-1 == err || (pivots.size() == 0 && 1 == err)) {
-							std::cout << "not valid file3\n";
-							throw 3;
-						}
+		// reading the file, stage 1 and building the tree overlap, for large files (cold cache).
+		inline std::pair<bool, size_t> ParsePipelined(const std::string& fileName, UserType* ut, size_t block_size = PIPELINE_BLOCK_SIZE);
 
-						for (int i = start + 1; i <= last; ++i) {
+		inline int Parse_One(const std::string& str, Data& data);
 
-							if (chk[i]) {
-								continue;
-							}
+		// lazy - keys and values are kept as offsets in the input, converted on first get_value() (and cached).
+		//   the input stays in the Parser while the document lives, errors in values are found on first access, get_value throws.
+		void set_lazy(bool lazy) {
+			lazy_mode = lazy;
+		}
 
-							// linearly merge and error check...
-							int before = i - 1;
-							for (int k = i - 1; k >= 0; --k) {
-								if (chk[k] == 0) {
-									before = k;
-									break;
-								}
-							}
+		bool is_lazy() const {
+			return lazy_mode;
+		}
 
-							int err = Merge(next[before], &__global[i], &next[i]);
+		// lazy subtrees - Parse makes only the root value, a container is expanded into its children on first
+		//   get_data, get_data_list or find ( UserType::Expand, thread safe ), its items are lazy as with set_lazy.
+		//   the structure is checked and the brackets are matched in Parse, the bracket index stays while the document lives.
+		//   ParsePipelined uses Parse. Release and Parse_One expand and convert all. ( index_threshold : auto_index is set by Expand )
+		void set_lazy_subtrees(bool on) {
+			lazy_subtrees = on;
+		}
 
-							if (-1 == err) {
-								std::cout << "chk " << i << " " << __global.size() << "\n";
-								std::cout << "not valid file4\n";
-								throw 4;
-							}
-							else if (i == last && 1 == err) {
-								std::cout << "not valid file5\n";
-								throw 5;
-							}
-						}
-					}
-					//catch (...) {
-						//throw "in Merge, error";
-					//	return false;
-					//}
-					//
+		bool is_lazy_subtrees() const {
+			return lazy_subtrees;
+		}
 
-					if (_global.get_data_size() > 1) {
-						std::cout << "not valid file6\n";
-						throw 6;
-					}
+		// intern keys - same key -> same string, in one KeyTable of the document.
+		//   less memory for repeated keys, and find_ut(Key) compares pointers.
+		void set_intern_keys(bool intern) {
+			intern_keys = intern;
+		}
 
+		bool is_intern_keys() const {
+			return intern_keys;
+		}
 
-					before_next = next.back();
+		// keys of the last document, nullptr : not interned.
+		const KeyTable* get_key_table() const {
+			return key_table.get();
+		}
 
-					auto c = std::chrono::steady_clock::now();
-					auto dur2 = std::chrono::duration_cast<std::chrono::nanoseconds>(c - b);
-					std::cout << "parse2 " << dur2.count() << "ns\n";
-				}
-			}
-			//int a = clock();
+		// huge pages for the node pool and the simdjson buffers ( input, string_buf, structural_indexes ),
+		//   new ones are pre-faulted on all threads. the file is read, not mapped.
+		void set_huge_pages(simdjson::dom::huge_page_mode mode) {
+			test.set_huge_pages(mode);
+		}
 
-			Merge(&global, &_global, nullptr);
+		simdjson::dom::huge_page_mode get_huge_pages() const {
+			return test.huge_pages();
+		}
 
-			/// global = std::move(_global);
-			//int b = clock();
-			//std::cout << "chk " << b - a << "ms\n";
-			return true;
+		// objects with n or more children get a key index ( UserType::set_auto_index ), n == 0 : off.
+		//   eager - the indexes are built in Parse, else on the first find or find_ut.
+		void set_index_threshold(size_t n, bool eager = false) {
+			index_threshold = n;
+			eager_index = eager;
 		}
-		static bool parse(claujson::UserType* pool, class UserType& global, const std::unique_ptr<char[]>& buf, size_t buf_len,
-				const std::unique_ptr<uint8_t[]>& string_buf,
-				const std::unique_ptr<simdjson::internal::dom_parser_implementation>& imple,
-				int64_t length, std::vector<int64_t>& start, int thr_num, std::vector<Block>& blocks) {
 
-			return LoadData::_LoadData(pool, global, buf, buf_len, string_buf, imple, length, start, thr_num, blocks);
+		size_t get_index_threshold() const {
+			return index_threshold;
 		}
 
-		//
-		static void _save(std::ostream& stream, UserType* ut, const int depth = 0) {
-			if (!ut) { return; }
+		// Parse builds only these paths ( JSON Pointers, "*" : any key or index ), other values are skipped without nodes,
+		//   their structure is still checked. empty : the whole document. ParsePipelined uses Parse with a projection.
+		//   throws if a path is not a JSON Pointer.
+		void set_projection(const std::vector<std::string>& paths) {
+			projection = Projection(paths);
+		}
 
-			if (ut->is_object()) {
-				for (size_t i = 0; i < ut->get_data_size(); ++i) {
-					if (ut->get_data_list(i)->is_user_type()) {
-						auto& x = ut->get_data_list(i)->value;
+		const Projection& get_projection() const {
+			return projection;
+		}
 
-						if (
-							x.key.type == simdjson::internal::tape_type::STRING) {
-							stream << "\"";
-							for (long long j = 0; j < ((std::string)(*x.key.get_str_val())).size(); ++j) {
-								switch ((*x.key.get_str_val())[j]) {
-								case '\\':
-									stream << "\\\\";
-									break;
-								case '\"':
-									stream << "\\\"";
-									break;
-								case '\n':
-									stream << "\\n";
-									break;
+		// Parse and ParsePipelined also match the brackets of the tokens, for get_cursor. ( 4 bytes per token )
+		void set_bracket_index(bool on) {
+			bracket_index = on;
+		}
 
-								default:
-									if (isprint((*x.key.get_str_val())[j]))
-									{
-										stream << (*x.key.get_str_val())[j];
-									}
-									else
-									{
-										int code = (*x.key.get_str_val())[j];
-										if (code > 0 && (code < 0x20 || code == 0x7F))
-										{
-											char buf[] = "\\uDDDD";
-											sprintf(buf + 2, "%04X", code);
-											stream << buf;
-										}
-										else {
-											stream << (*x.key.get_str_val())[j];
-										}
-									}
-								}
-							}
+		bool is_bracket_index() const {
+			return bracket_index;
+		}
 
-							stream << "\"";
+		// at the root value of the last document ( the projected tokens with a projection ), the bracket index is built if it is not.
+		//   valid until the next parse or Trim. an invalid Cursor if there is no document.
+		Cursor get_cursor() {
+			if (doc_tokens <= 0 || (bracket_match.empty() && !MatchBrackets())) {
+				return Cursor();
+			}
+			return Cursor(test.raw_buf(), test.raw_string_buf(), test.raw_implementation()->structural_indexes.get(), bracket_match.data(), doc_tokens);
+		}
 
-							if (x.key.is_key) {
-								stream << " : ";
-							}
-						}
-						else {
-							std::cout << "Error : no key\n";
-						}
-						stream << " ";
+		// memory of the last document and of this Parser ( kept node pool, simdjson buffers ),
+		//   ut : root of the last document, also its heap strings and lists ( O(n) ), nullptr : without them.
+		inline MemoryUsage memory_usage(const UserType* ut = nullptr);
 
-						if (((UserType*)ut->get_data_list(i))->is_object()) {
-							stream << " { \n";
-						}
-						else {
-							stream << " [ \n";
-						}
+		// the largest memory_usage() at the ends of the phases of Parse and ParsePipelined ( stage 1, node pool, tree ),
+		//   since the Parser was made or reset_peak_memory_usage().
+		MemoryUsage get_peak_memory_usage() const {
+			return peak_usage;
+		}
 
-						_save(stream, (UserType*)ut->get_data_list(i), depth + 1);
+		void reset_peak_memory_usage() {
+			peak_usage = MemoryUsage();
+		}
 
-						if (((UserType*)ut->get_data_list(i))->is_object()) {
-							stream << " } \n";
-						}
-						else {
-							stream << " ] \n";
-						}
-					}
-					else {
-						auto& x = ut->get_data_list(i)->value;
+		// add or remove nodes of the last document.
+		PoolManager& get_pool_manager() {
+			return manager;
+		}
 
-						if (
-							x.key.type == simdjson::internal::tape_type::STRING) {
-							stream << "\"";
-							for (long long j = 0; j < (*x.key.get_str_val()).size(); ++j) {
-								switch ((*x.key.get_str_val())[j]) {
-								case '\\':
-									stream << "\\\\";
-									break;
-								case '\"':
-									stream << "\\\"";
-									break;
-								case '\n':
-									stream << "\\n";
-									break;
+		ThreadPool& get_thread_pool() {
+			return *thread_pool;
+		}
 
-								default:
-									if (isprint((*x.key.get_str_val())[j]))
-									{
-										stream << (*x.key.get_str_val())[j];
-									}
-									else
-									{
-										int code = (*x.key.get_str_val())[j];
-										if (code > 0 && (code < 0x20 || code == 0x7F))
-										{
-											char buf[] = "\\uDDDD";
-											sprintf(buf + 2, "%04X", code);
-											stream << buf;
-										}
-										else {
-											stream << (*x.key.get_str_val())[j];
-										}
-									}
-								}
-							}
+		int get_thread_num() const {
+			return thr_num;
+		}
 
-							stream << "\"";
+		// the nodes of the last document -> caller, ex) PoolManager(std::move(pools), std::move(blocks))
+		// strings and child lists are copied out of the arenas. ( one new per string, Release(PoolManager&) does not copy )
+		void Release(std::vector<UserType*>& pools, std::vector<Block>& blocks) {
+			DecodeAll(); // the nodes can live longer than the input.
+			CopyOutOfArenas();
+			lazy_input.SetKeyTable(nullptr);
+			key_table.reset();
+			manager.Release(pools, blocks);
+			used.clear();
+			doc_pool_size = 0;
+		}
 
-							if (x.key.is_key) {
-								stream << " : ";
-							}
-						}
+		// the nodes of the last document and their string arenas -> manager. ( manager should be empty )
+		void Release(PoolManager& manager) {
+			DecodeAll();
+			lazy_input.ReleaseArenas(this->manager);
+			this->manager.SetKeyTable(std::move(key_table));
+			manager = std::move(this->manager);
+			this->manager = PoolManager();
+			used.clear();
+			doc_pool_size = 0;
+		}
 
-						{
-							auto& x = ut->get_data_list(i)->value;
+		// nodes of the last document -> one new pool in order, the old pool is freed. ( see claujson::Compact )
+		inline bool Compact(UserType* ut, NodeOrder order = NodeOrder::DFS);
 
-							if (
-								x.data.type == simdjson::internal::tape_type::STRING) {
-								stream << "\"";
-								for (long long j = 0; j < ((std::string&)(*x.data.get_str_val())).size(); ++j) {
-									switch ((*x.data.get_str_val())[j]) {
-									case '\\':
-										stream << "\\\\";
-										break;
-									case '\"':
-										stream << "\\\"";
-										break;
-									case '\n':
-										stream << "\\n";
-										break;
+		// destroy the nodes of the last document, its node pool is kept for the next Parse.
+		inline void Clear();
 
-									default:
-										if (isprint((*x.data.get_str_val())[j]))
-										{
-											stream << (*x.data.get_str_val())[j];
-										}
-										else
-										{
-											int code = (*x.data.get_str_val())[j];
-											if (code > 0 && (code < 0x20 || code == 0x7F))
-											{
-												char buf[] = "\\uDDDD";
-												sprintf(buf + 2, "%04X", code);
-												stream << buf;
-											}
-											else {
-												stream << (*x.data.get_str_val())[j];
-											}
-										}
-									}
-								}
+		// Clear, and free the kept node pool and the simdjson buffers. (worker threads are kept)
+		void Trim() {
+			Clear();
+			doc_tokens = 0;
+			bracket_match = std::vector<uint32_t>();
+			if (spare_pool) {
+				FreePool(spare_pool);
+				spare_pool = nullptr;
+				spare_pool_size = 0;
+			}
+			const auto huge_pages = test.huge_pages();
+			test = simdjson::dom::parser();
+			test.set_huge_pages(huge_pages);
+		}
+	private:
+		// bracket_match of the last document, on the thread pool. false : brackets do not match.
+		bool MatchBrackets() {
+			const auto& imple = test.raw_implementation();
+			std::vector<int64_t> start(thr_num + 1, 0);
+			std::vector<int64_t> pivots;
 
-								stream << "\"";
+			LoadData::SetDivisionStart(imple, test.raw_len(), doc_tokens, start, thr_num);
+			LoadData::SetPivots(test.raw_buf(), imple, doc_tokens, start, thr_num, pivots);
+			if (!LoadData::MatchBrackets(test.raw_buf(), imple, doc_tokens, pivots, bracket_match, *thread_pool, thr_num)) {
+				bracket_match.clear();
+				return false;
+			}
+			return true;
+		}
 
-							}
-							else if (x.data.type == simdjson::internal::tape_type::TRUE_VALUE) {
-								stream << "true";
-							}
-							else if (x.data.type == simdjson::internal::tape_type::FALSE_VALUE) {
-								stream << "false";
-							}
-							else if (x.data.type == simdjson::internal::tape_type::DOUBLE) {
-								stream << std::fixed << std::setprecision(6) << (x.data.float_val);
-							}
-							else if (x.data.type == simdjson::internal::tape_type::INT64) {
-								stream << x.data.int_val;
-							}
-							else if (x.data.type == simdjson::internal::tape_type::UINT64) {
-								stream << x.data.uint_val;
-							}
-							else if (x.data.type == simdjson::internal::tape_type::NULL_VALUE) {
-								stream << "null ";
-							}
+		void UpdatePeak() {
+			MemoryUsage x = memory_usage();
+			if (x.total() > peak_usage.total()) {
+				peak_usage = x;
+			}
+		}
+
+		// f(node) for the nodes of the last document, on the thread pool. ( nodes not removed by edits )
+		//   doc_subtrees : the nodes made by Expand are not in used, the trees of the nodes in used are walked,
+		//   f of a node is called before its children are read.
+		template <class F>
+		void ForEachDocNode(F f) {
+			if (!doc_subtrees) {
+				thread_pool->ParallelFor((int64_t)used.size(), thr_num, [&](int64_t i) {
+					for (int64_t j = 0; j < used[i].size; ++j) {
+						UserType* x = used[i].pool + used[i].start + j;
+						if (x->alloc_type == PoolManager::Type::FROM_POOL) {
+							f(x);
 						}
 					}
+				});
+				return;
+			}
 
-					if (i < ut->get_data_size() - 1) {
-						stream << ", ";
+			std::vector<UserType*> level;
+			for (const auto& block : used) {
+				for (int64_t j = 0; j < block.size; ++j) {
+					UserType* x = block.pool + block.start + j;
+					if (x->alloc_type == PoolManager::Type::FROM_POOL) {
+						level.push_back(x);
 					}
 				}
 			}
-			else if (ut->is_array()) {
-				for (size_t i = 0; i < ut->get_data_size(); ++i) {
-					if (ut->get_data_list(i)->is_user_type()) {
-
-
-						if (((UserType*)ut->get_data_list(i))->is_object()) {
-							stream << " { \n";
-						}
-						else {
-							stream << " [ \n";
-						}
+			// the top levels here, until there are subtrees for all threads.
+			while (!level.empty() && level.size() < size_t(thr_num) * 16) {
+				std::vector<UserType*> next;
+				for (UserType* x : level) {
+					f(x);
+					next.insert(next.end(), x->list().begin(), x->list().end());
+				}
+				level = std::move(next);
+			}
+			thread_pool->ParallelFor((int64_t)level.size(), thr_num, [&](int64_t i) {
+				std::vector<UserType*> stack{ level[i] };
+				while (!stack.empty()) {
+					UserType* x = stack.back();
+					stack.pop_back();
+					f(x);
+					stack.insert(stack.end(), x->list().begin(), x->list().end());
+				}
+			});
+		}
 
+		// convert all lazy nodes ( and expand all containers ) of the last document, then its nodes do not need the input.
+		void DecodeAll() {
+			if (!doc_lazy) {
+				return;
+			}
+			ForEachDocNode([](UserType* x) {
+				x->Expand();
+				x->Decode();
+			});
+			doc_lazy = false;
+		}
 
-						_save(stream, (UserType*)ut->get_data_list(i), depth + 1);
+		// strings and child lists of the last document -> not in the arenas.
+		void CopyOutOfArenas() {
+			ForEachDocNode([](UserType* x) {
+				x->drop_index(); // views of the strings, rebuilt if auto_index.
+				x->value.key.own_str_val();
+				x->value.data.own_str_val();
+				x->Own(); // also the container record.
+			});
+		}
 
-						if (((UserType*)ut->get_data_list(i))->is_object()) {
-							stream << " } \n";
-						}
-						else {
-							stream << " ] \n";
+		// objects of the last document with index_threshold or more children -> auto_index, ( + the index, if eager_index )
+		void MarkIndexes() {
+			if (index_threshold == 0) {
+				return;
+			}
+			thread_pool->ParallelFor((int64_t)used.size(), thr_num, [this](int64_t i) {
+				for (int64_t j = 0; j < used[i].size; ++j) {
+					UserType* x = used[i].pool + used[i].start + j;
+					if (x->alloc_type == PoolManager::Type::FROM_POOL && x->is_object() && x->list().size() >= index_threshold) {
+						x->box->auto_index = true;
+						if (eager_index) {
+							x->build_index();
 						}
 					}
-					else {
-
-						auto& x = ut->get_data_list(i)->value;
-
-						if (
-							x.data.type == simdjson::internal::tape_type::STRING) {
-							stream << "\"";
-							for (long long j = 0; j < (*x.data.get_str_val()).size(); ++j) {
-								switch ((*x.data.get_str_val())[j]) {
-								case '\\':
-									stream << "\\\\";
-									break;
-								case '\"':
-									stream << "\\\"";
-									break;
-								case '\n':
-									stream << "\\n";
-									break;
+				}
+			});
+		}
 
-								default:
-									if (isprint((*x.data.get_str_val())[j]))
-									{
-										stream << (*x.data.get_str_val())[j];
-									}
-									else
-									{
-										int code = (*x.data.get_str_val())[j];
-										if (code > 0 && (code < 0x20 || code == 0x7F))
-										{
-											char buf[] = "\\uDDDD";
-											sprintf(buf + 2, "%04X", code);
-											stream << buf;
-										}
-										else {
-											stream << (*x.data.get_str_val())[j];
-										}
-									}
-								}
-							}
+		// constructed nodes = pool segments - free blocks.
+		void SetUsed(const std::vector<Block>& segments, std::vector<Block> blocks) {
+			used.clear();
 
-							stream << "\"";
-						}
-						else if (x.data.type == simdjson::internal::tape_type::TRUE_VALUE) {
-							stream << "true";
-						}
-						else if (x.data.type == simdjson::internal::tape_type::FALSE_VALUE) {
-							stream << "false";
-						}
-						else if (x.data.type == simdjson::internal::tape_type::DOUBLE) {
-							stream << std::fixed << std::setprecision(6) << (x.data.float_val);
-						}
-						else if (x.data.type == simdjson::internal::tape_type::INT64) {
-							stream << x.data.int_val;
-						}
-						else if (x.data.type == simdjson::internal::tape_type::UINT64) {
-							stream << x.data.uint_val;
-						}
-						else if (x.data.type == simdjson::internal::tape_type::NULL_VALUE) {
-							stream << "null ";
-						}
+			std::sort(blocks.begin(), blocks.end(), [](const Block& x, const Block& y) {
+				return x.pool < y.pool || (x.pool == y.pool && x.start < y.start);
+			});
 
+			for (const auto& segment : segments) {
+				auto iter = std::lower_bound(blocks.begin(), blocks.end(), segment.pool, [](const Block& x, UserType* pool) {
+					return x.pool < pool;
+				});
 
-						stream << " ";
+				int64_t last = segment.start;
+				for (; iter != blocks.end() && iter->pool == segment.pool; ++iter) {
+					if (iter->start > last) {
+						used.push_back(Block{ last, iter->start - last, segment.pool });
 					}
+					last = iter->start + iter->size;
+				}
+				if (segment.start + segment.size > last) {
+					used.push_back(Block{ last, segment.start + segment.size - last, segment.pool });
+				}
+			}
+		}
+	};
 
-					if (i < ut->get_data_size() - 1) {
-						stream << ", ";
-					}
+	inline void Parser::Clear() {
+		manager.DestroyNodes(); // also the nodes added by edits.
+		used.clear();
+
+		std::vector<UserType*> pools;
+		std::vector<Block> blocks;
+		manager.Release(pools, blocks);
+		manager.Clear(); // arenas.
+
+		// keep the largest node pool.
+		for (auto* pool : pools) {
+			if (doc_pool_size > spare_pool_size) {
+				if (spare_pool) {
+					FreePool(spare_pool);
 				}
+				spare_pool = pool;
+				spare_pool_size = doc_pool_size;
+			}
+			else {
+				FreePool(pool);
 			}
 		}
+		doc_pool_size = 0;
+		doc_lazy = false;
+		doc_subtrees = false;
+		lazy_input.ClearArenas();
+		lazy_input.SetKeyTable(nullptr);
+		key_table.reset();
+	}
 
-		static void save(const std::string& fileName, class UserType& global) {
-			std::ofstream outFile;
-			outFile.open(fileName, std::ios::binary); // binary!
+	inline bool Parser::Compact(UserType* ut, NodeOrder order) {
+		UserType out;
+		UserType* pool = nullptr;
+		int64_t pool_size = 0;
+		StringArena arena;
+		std::unique_ptr<KeyTable> table;
 
-			_save(outFile, &global);
+		if (!LoadData::_Compact(ut, &out, pool, pool_size, arena, table, order)) {
+			return false;
+		}
 
-			outFile.close();
+		Clear();
+		if (spare_pool) { // the old pool.
+			FreePool(spare_pool);
+			spare_pool = nullptr;
+			spare_pool_size = 0;
 		}
-	};
 
-	inline 	std::pair<claujson::UserType*, size_t> Parse(const std::string& fileName, int thr_num, UserType* ut, std::vector<Block>& blocks)
-	{
-		if (thr_num <= 0) {
-			thr_num = std::thread::hardware_concurrency();
+		LoadData::MoveRoot(ut, &out);
+		manager = PoolManager(pool, {}, pool_size);
+		if (arena.get_block_num() > 0) {
+			manager.AddArena(std::move(arena));
+		}
+		key_table = std::move(table);
+		used = { Block{ 0, pool_size, pool } };
+		doc_pool_size = pool_size;
+		MarkIndexes();
+		return true;
+	}
+
+	inline MemoryUsage Parser::memory_usage(const UserType* ut) {
+		MemoryUsage x = manager.memory_usage(ut);
+		if (spare_pool) {
+			x.nodes += size_t(spare_pool_size) * sizeof(UserType);
 		}
-		if (thr_num <= 0) {
-			thr_num = 1;
+		if (key_table) {
+			x.strings += key_table->get_bytes();
+		}
+		lazy_input.AddMemoryUsage(x);
+		x.stage1 = test.stage1_bytes() + bracket_match.capacity() * sizeof(uint32_t);
+		x.input = test.input_bytes();
+		return x;
+	}
+
+	inline std::pair<bool, size_t> Parser::Parse(const std::string& fileName, UserType* ut, int chunk_per_thread)
+	{
+		Clear();
+		doc_tokens = 0;
+		bracket_match.clear();
+
+		if (chunk_per_thread <= 0) {
+			chunk_per_thread = 1;
 		}
+		const int chunk_num = thr_num * chunk_per_thread;
 
-		claujson::UserType* pool = nullptr;
 		int64_t length;
 
 		int _ = clock();
 
 		{
-			static simdjson::dom::parser test;
+			// stage 1 on thr_num threads.
+			auto x = test.load_parallel(fileName, thr_num, [this](size_t n, const auto& f) {
+				thread_pool->ParallelFor(n, thr_num, f);
+			});
 
-			auto x = test.load(fileName);
-			
 			if (x.error() != simdjson::error_code::SUCCESS) {
 				std::cout << x.error() << "\n";
 
-				return { nullptr, 0 };
+				return { false, 0 };
 			}
 
 			if (!test.valid) {
@@ -2254,13 +6366,14 @@ namespace claujson {
 
 					//return -2;
 			}
+			UpdatePeak(); // input and stage 1.
 
 			const auto& buf = test.raw_buf();
 			const auto& string_buf = test.raw_string_buf();
 			const auto& imple = test.raw_implementation();
 			const auto buf_len = test.raw_len();
 
-			std::vector<int64_t> start(thr_num + 1, 0);
+			std::vector<int64_t> start(chunk_num + 1, 0);
 			//std::vector<int> key;
 		
 			int a = clock();
@@ -2272,10 +6385,7 @@ namespace claujson {
 				size_t how_many = imple->n_structural_indexes;
 				length = how_many;
 
-				start[0] = 0;
-				for (int i = 1; i < thr_num; ++i) {
-					start[i] = how_many / thr_num * i;
-				}
+				claujson::LoadData::SetDivisionStart(imple, buf_len, length, start, chunk_num);
 
 				int c = clock();
 
@@ -2413,15 +6523,124 @@ namespace claujson {
 
 			std::cout << b - a << "ms\n";
 
-			start[thr_num] = length;
+			start[chunk_num] = length;
 
-			pool = (claujson::UserType*)calloc(length, sizeof(claujson::UserType));
+			std::vector<int64_t> pivots;
+			std::vector<int64_t> node_offsets;
 
-			if (false == claujson::LoadData::parse(pool, *ut, buf, buf_len, string_buf, imple, length, start, thr_num, blocks)) // 0 : use all thread..
-			{
-				free(pool);
-				return { nullptr, 0 };
+			if (!projection.empty()) { // only the tokens of the paths are left.
+				claujson::LoadData::SetPivots(buf, imple, length, start, chunk_num, pivots);
+				if (!claujson::LoadData::Project(projection, buf, buf_len, imple, length, pivots, *thread_pool, thr_num)) {
+					std::cout << "wrong structure\n";
+					return { false, 0 };
+				}
+				claujson::LoadData::SetDivisionStart(imple, buf_len, length, start, chunk_num);
+			}
+
+			claujson::LoadData::SetPivots(buf, imple, length, start, chunk_num, pivots);
+
+			int64_t node_num = 1; // lazy_subtrees : only the root value, the rest of the pool is for Expand.
+			if (lazy_subtrees) {
+				if (projection.empty() && !claujson::LoadData::CheckStructure(buf, imple, length, pivots, *thread_pool, thr_num)) {
+					std::cout << "wrong structure\n";
+					return { false, 0 };
+				}
+				doc_tokens = length;
+				if (!MatchBrackets()) {
+					doc_tokens = 0;
+					return { false, 0 };
+				}
+			}
+			else {
+				// exact number of nodes, not one node per token.
+				node_num = claujson::LoadData::SetNodeOffsets(buf, imple, length, pivots, node_offsets, *thread_pool, thr_num);
+			}
+
+			// reuse the node pool of the last document, if it is big enough.
+			if (spare_pool && spare_pool_size < node_num) {
+				FreePool(spare_pool);
+				spare_pool = nullptr;
+				spare_pool_size = 0;
+			}
+			if (!spare_pool) {
+				spare_pool = NewPool(node_num, test.huge_pages());
+				if (!spare_pool) {
+					return { false, 0 };
+				}
+				spare_pool_size = node_num;
+
+				// page faults of the new pool here, on all threads, not in __LoadData.
+				if (test.huge_pages() != simdjson::dom::huge_page_mode::off) {
+					simdjson::internal::prefault((char*)spare_pool, size_t(node_num) * sizeof(UserType), thr_num, [this](size_t n, const auto& f) {
+						thread_pool->ParallelFor(n, thr_num, f);
+					});
+				}
+			}
+			UserType* pool = spare_pool;
+			UpdatePeak(); // + node pool.
+
+			std::vector<Block> blocks;
+			std::vector<StringArena> arenas;
+
+			if (intern_keys) {
+				key_table.reset(new KeyTable());
+			}
+			lazy_input.SetKeyTable(key_table.get());
+
+			lazy_input.buf = &buf;
+			lazy_input.string_buf = &string_buf;
+			lazy_input.first_idx = imple->structural_indexes[0];
+			doc_lazy = lazy_mode;
+
+			if (lazy_subtrees) {
+				lazy_input.structural_indexes = imple->structural_indexes.get();
+				lazy_input.match = bracket_match.data();
+				lazy_input.index_threshold = index_threshold;
+				lazy_input.manager = &manager; // the nodes of the document, below.
+				doc_lazy = true;
+				doc_subtrees = true;
+
+				ut->LinkUserType(UserType::make_lazy_root(pool, buf, string_buf, imple->structural_indexes.get(), bracket_match.data(), &lazy_input));
+			}
+			else {
+				bool ok = false;
+				try { // bad_alloc of the workers, ParallelFor throws it after all are done.
+					ok = claujson::LoadData::parse(pool, *ut, buf, buf_len, string_buf, imple, length, pivots, node_offsets, blocks, arenas, key_table.get(), *thread_pool, thr_num,
+						lazy_mode ? &lazy_input : nullptr); // 0 : use all thread..
+				}
+				catch (const std::bad_alloc&) {
+					std::cout << "not enough memory\n";
+				}
+				if (!ok) {
+					doc_lazy = false;
+					return { false, 0 };
+				}
+			}
+
+			for (auto& block : blocks) {
+				block.pool = pool;
+			}
+			SetUsed({ Block{ 0, node_num, pool } }, blocks);
+
+			if (spare_pool_size > node_num) { // rest of the reused pool, for edits.
+				blocks.push_back(Block{ node_num, spare_pool_size - node_num, pool });
 			}
+
+			spare_pool = nullptr;
+			doc_pool_size = spare_pool_size;
+			spare_pool_size = 0;
+			manager = PoolManager(pool, std::move(blocks), doc_pool_size);
+			for (auto& x : arenas) {
+				if (x.get_block_num() > 0) {
+					manager.AddArena(std::move(x));
+				}
+			}
+			MarkIndexes();
+			doc_tokens = length;
+			if (bracket_index && bracket_match.empty() && !MatchBrackets()) {
+				return { false, 0 };
+			}
+			UpdatePeak(); // + tree.
 			int c = clock();
 			std::cout << c - b << "ms\n";
 		}
@@ -2430,13 +6649,95 @@ namespace claujson {
 
 		// claujson::LoadData::_save(std::cout, &ut);
 
-		return { pool, length };
+		return { true, length };
 	}
 
-	inline int Parse_One(const std::string& str, Data& data) {
-		{
-			static simdjson::dom::parser test;
+	inline std::pair<bool, size_t> Parser::ParsePipelined(const std::string& fileName, UserType* ut, size_t block_size)
+	{
+		if (!projection.empty() || lazy_subtrees) { // needs all tokens first.
+			return Parse(fileName, ut);
+		}
+
+		Clear();
+		doc_tokens = 0;
+		bracket_match.clear();
+
+		if (block_size <= 0) {
+			block_size = PIPELINE_BLOCK_SIZE;
+		}
+
+		size_t len = 0;
+		auto error = test.load_begin(fileName).get(len);
+		if (error) {
+			std::cout << error << "\n";
+			return { false, 0 };
+		}
+		if (len == 0) {
+			std::cout << "empty\n";
+			return { false, 0 };
+		}
+
+		int64_t length = 0;
+		std::vector<UserType*> pools;
+		std::vector<int64_t> pool_sizes;
+		std::vector<Block> blocks;
+		std::vector<StringArena> arenas;
 
+		if (intern_keys) {
+			key_table.reset(new KeyTable());
+		}
+		lazy_input.SetKeyTable(key_table.get());
+
+		lazy_input.buf = &test.raw_buf();
+		lazy_input.string_buf = &test.raw_string_buf();
+
+		bool ok = false;
+		try { // bad_alloc of merging, tree tasks give it in their err.
+			ok = claujson::LoadData::_LoadDataPipelined(test, len, *ut, pools, pool_sizes, blocks, arenas, key_table.get(), block_size, *thread_pool, thr_num, length,
+				error, lazy_mode ? &lazy_input : nullptr);
+		}
+		catch (const std::bad_alloc&) {
+			std::cout << "not enough memory\n";
+		}
+		if (!ok) {
+			if (error) {
+				std::cout << error << "\n";
+			}
+			for (auto* x : pools) {
+				FreePool(x);
+			}
+			return { false, 0 };
+		}
+
+		lazy_input.first_idx = test.raw_implementation()->structural_indexes[0];
+		doc_lazy = lazy_mode;
+
+		std::vector<Block> segments;
+		for (size_t i = 0; i < pools.size(); ++i) {
+			segments.push_back(Block{ 0, pool_sizes[i], pools[i] });
+		}
+		SetUsed(segments, blocks);
+		manager = PoolManager(std::move(pools), std::move(blocks), std::move(pool_sizes));
+		for (auto& x : arenas) {
+			if (x.get_block_num() > 0) {
+				manager.AddArena(std::move(x));
+			}
+		}
+		MarkIndexes();
+		doc_tokens = length;
+		if (bracket_index && !MatchBrackets()) {
+			return { false, 0 };
+		}
+		UpdatePeak(); // stages overlap, only the end.
+
+		return { true, (size_t)length };
+	}
+
+	inline int Parser::Parse_One(const std::string& str, Data& data) {
+		DecodeAll(); // test`s buffers are overwritten.
+		doc_tokens = 0;
+		bracket_match.clear();
+		{
 			auto x = test.parse(str);
 
 			if (x.error() != simdjson::error_code::SUCCESS) {
@@ -2452,4 +6753,122 @@ namespace claujson {
 		}
 		return 0;
 	}
+
+	// thread_pool - nullptr : use ThreadPool::Default()
+	// chunk_per_thread - > 1 : cut into thr_num * chunk_per_thread chunks, and idle threads steal chunks. (for irregular documents, busy machines)
+	// the nodes are in the returned pool -> PoolManager(pool, std::move(blocks)), strings and child lists are copied out of the arenas.
+	inline 	std::pair<claujson::UserType*, size_t> Parse(const std::string& fileName, int thr_num, UserType* ut, std::vector<Block>& blocks,
+		ThreadPool* thread_pool = nullptr, int chunk_per_thread = 1)
+	{
+		Parser parser(thread_pool ? *thread_pool : ThreadPool::Default(), thr_num);
+
+		auto x = parser.Parse(fileName, ut, chunk_per_thread);
+		if (!x.first) {
+			return { nullptr, 0 };
+		}
+
+		std::vector<UserType*> pools;
+		parser.Release(pools, blocks);
+
+		return { pools[0], x.second };
+	}
+
+	// the nodes and their strings -> manager, freed by manager.Clear()
+	// return : { success?, the number of tokens }
+	inline std::pair<bool, size_t> Parse(const std::string& fileName, int thr_num, UserType* ut, PoolManager& manager,
+		ThreadPool* thread_pool = nullptr, int chunk_per_thread = 1)
+	{
+		Parser parser(thread_pool ? *thread_pool : ThreadPool::Default(), thr_num);
+
+		auto x = parser.Parse(fileName, ut, chunk_per_thread);
+		if (x.first) {
+			parser.Release(manager);
+		}
+
+		return x;
+	}
+
+	// reading the file, stage 1 and building the tree overlap, for large files (cold cache).
+	// nodes are in pools (one per chunk) -> PoolManager(std::move(pools), std::move(blocks)), strings and child lists are copied out of the arenas.
+	// return : { success?, the number of tokens }
+	inline std::pair<bool, size_t> ParsePipelined(const std::string& fileName, int thr_num, UserType* ut, std::vector<UserType*>& pools,
+		std::vector<Block>& blocks, ThreadPool* thread_pool = nullptr, size_t block_size = PIPELINE_BLOCK_SIZE)
+	{
+		Parser parser(thread_pool ? *thread_pool : ThreadPool::Default(), thr_num);
+
+		auto x = parser.ParsePipelined(fileName, ut, block_size);
+		if (!x.first) {
+			pools.clear();
+			blocks.clear();
+			return x;
+		}
+
+		parser.Release(pools, blocks);
+
+		return x;
+	}
+
+	// the nodes and their strings -> manager, freed by manager.Clear()
+	inline std::pair<bool, size_t> ParsePipelined(const std::string& fileName, int thr_num, UserType* ut, PoolManager& manager,
+		ThreadPool* thread_pool = nullptr, size_t block_size = PIPELINE_BLOCK_SIZE)
+	{
+		Parser parser(thread_pool ? *thread_pool : ThreadPool::Default(), thr_num);
+
+		auto x = parser.ParsePipelined(fileName, ut, block_size);
+		if (x.first) {
+			parser.Release(manager);
+		}
+
+		return x;
+	}
+
+	inline int Parse_One(const std::string& str, Data& data) {
+		Parser parser(ThreadPool::Default(), 1);
+
+		return parser.Parse_One(str, data);
+	}
+
+	// compaction, after many edits the nodes are spread over pools, slabs and the dead list.
+
+	// copy of the tree of root in one new pool ( exact size ) and one arena, nodes in DFS or BFS order.
+	//   root is only read, so other threads can keep reading the old tree while this runs.
+	//   out : root of the copy, out_manager : gets its nodes. ( should be empty )
+	//   ex) auto f = std::async(std::launch::async, [&]() { claujson::Compact(&ut, &copy, copy_manager); });
+	//       ... f.get(); claujson::SwapCompacted(&ut, manager, &copy, copy_manager);
+	inline bool Compact(const UserType* root, UserType* out, PoolManager& out_manager, NodeOrder order = NodeOrder::DFS) {
+		UserType* pool = nullptr;
+		int64_t pool_size = 0;
+		StringArena arena;
+		std::unique_ptr<KeyTable> key_table;
+
+		if (!LoadData::_Compact(root, out, pool, pool_size, arena, key_table, order)) {
+			return false;
+		}
+
+		out_manager = PoolManager(pool, {}, pool_size);
+		if (arena.get_block_num() > 0) {
+			out_manager.AddArena(std::move(arena));
+		}
+		out_manager.SetKeyTable(std::move(key_table));
+		return true;
+	}
+
+	// root and manager <- out and out_manager ( from Compact ), the old nodes are destroyed and their memory is freed.
+	//   nobody should read the old tree from now.
+	inline void SwapCompacted(UserType* root, PoolManager& manager, UserType* out, PoolManager& out_manager) {
+		manager.DestroyNodes();
+		manager = std::move(out_manager);
+		LoadData::MoveRoot(root, out);
+	}
+
+	// Compact, then SwapCompacted.
+	inline bool Compact(UserType* root, PoolManager& manager, NodeOrder order = NodeOrder::DFS) {
+		UserType out;
+		PoolManager out_manager;
+		if (!Compact(root, &out, out_manager, order)) {
+			return false;
+		}
+		SwapCompacted(root, manager, &out, out_manager);
+		return true;
+	}
 }
@@ -7,7 +7,9 @@
 #endif
 
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
 #include <ctime>
 
 #include "claujson.h"
@@ -15,25 +17,89 @@
 
 using namespace std::literals::string_view_literals;
 
-namespace claujson {
-	UserType* ChkPool(UserType*& node, PoolManager& new_manager) {
-		if (nullptr == node) { return nullptr; }
-	
-		UserType* x = node;
-		node = new_manager.Alloc();
-		*node = *x;
+// compiled JSON Pointer vs find_ut chain, for each feature - geometry/coordinates/0
+// table - interned keys of the document, the pointer finds keys by their interned strings.
+// ex) main.exe citylots.json pointer
+static void bench_pointer(claujson::UserType* ut, const claujson::KeyTable* table) {
+	const claujson::UserType* features = claujson::JsonPointer("/features", table).Get(ut);
+	if (!features) {
+		return;
+	}
+	const claujson::JsonPointer pointer("/geometry/coordinates/0", table);
+	auto ms = [](int a) { return int64_t(clock() - a) * 1000 / CLOCKS_PER_SEC; };
 
-		node->next_dead = nullptr;
+	for (int i = 0; i < 5; ++i) {
+		{
+			int a = clock();
+			int64_t chk = 0;
+			for (const claujson::UserType* x : features->get_data()) {
+				const claujson::UserType* y = x->find_ut("geometry"sv);
+				if (y) {
+					y = y->find_ut("coordinates"sv);
+					if (y && y->get_data_size() > 0) {
+						chk += y->get_data_list(0)->get_data_size();
+					}
+				}
+			}
+			std::cout << "find_ut " << ms(a) << "ms chk " << chk << "\n";
+		}
+		{
+			int a = clock();
+			int64_t chk = 0;
+			for (const claujson::UserType* x : features->get_data()) {
+				if (const claujson::UserType* y = pointer.Get(x)) {
+					chk += y->get_data_size();
+				}
+			}
+			std::cout << "pointer " << ms(a) << "ms chk " << chk << "\n";
+		}
+	}
+}
 
-		for (size_t i = 0; i < node->data.size(); ++i) {
-			node->data[i]->parent = node;
-			ChkPool(node->data[i], new_manager);
+// append to each sealed ( in an arena ), non-empty child list and remove it again,
+// the strings and lists next to it in the arena must not change. ( the list is moved to the heap first )
+// ex) main.exe citylots.json check
+static bool check_sealed_append(claujson::UserType* ut, claujson::PoolManager& manager) {
+	std::ostringstream before;
+	claujson::LoadData::_save(before, ut);
+
+	std::vector<claujson::UserType*> sealed;
+	std::vector<claujson::UserType*> stack{ ut };
+	while (!stack.empty()) {
+		claujson::UserType* x = stack.back();
+		stack.pop_back();
+		if (x->is_user_type() && x->get_data_size() > 0 && x->get_data().is_sealed()) {
+			sealed.push_back(x);
 		}
+		for (size_t i = 0; i < x->get_data_size(); ++i) {
+			stack.push_back(x->get_data_list(i));
+		}
+	}
+
+	claujson::Data key, value;
+	key.set_str_val(std::string("check"));
+	key.is_key = true;
+	value.set_str_val(std::string("appended after the sealed list"));
 
-		return node;
+	for (claujson::UserType* x : sealed) {
+		if (x->is_object()) {
+			x->add_object_element(manager, key, value);
+		}
+		else {
+			x->add_array_element(manager, value);
+		}
 	}
-}
+	for (claujson::UserType* x : sealed) {
+		x->remove_data_list(manager, x->get_data_size() - 1);
+	}
+
+	std::ostringstream after;
+	claujson::LoadData::_save(after, ut);
 
+	const bool ok = before.str() == after.str();
+	std::cout << "sealed lists " << sealed.size() << (ok ? " ok\n" : " changed\n");
+	return ok;
+}
 
 
 int main(int argc, char* argv[])
@@ -43,27 +109,36 @@ int main(int argc, char* argv[])
 	claujson::UserType ut;
 	try {
 		int a = clock();
-		std::vector<claujson::Block> blocks;
+		claujson::PoolManager poolManager; // using pool manager, add Item or remove
 		
-		auto x = claujson::Parse(argv[1], 0, &ut, blocks);
+		const bool pointer = argc > 2 && std::string(argv[2]) == "pointer";
+
+		claujson::Parser parser(claujson::ThreadPool::Default());
+		parser.set_intern_keys(pointer); // for bench_pointer.
+		auto x = parser.Parse(argv[1], &ut);
 		if (!x.first) {
 			std::cout << "fail\n";
 			return 2;
 		}
-		claujson::PoolManager poolManager(x.first, std::move(blocks)); // using pool manager, add Item or remove
+		parser.Release(poolManager);
 
 		//std::vector<claujson::Block> blocks2{ claujson::Block{0, (int64_t)x.second}};
 		//claujson::PoolManager poolManager2{};
 
 		int b = clock();
 		std::cout << "total " << b - a << "ms\n";
+
+		if (pointer) {
+			bench_pointer(&ut, poolManager.get_key_table());
+		}
+		const bool checked = !(argc > 2 && std::string(argv[2]) == "check") || check_sealed_append(&ut, poolManager);
 		//claujson::LoadData::_save(std::cout, &ut);
 		//claujson::LoadData::save("output.json", ut);
 
 		//test2(&ut);
 /*
 		{
-			//claujson::ChkPool(ut.get_data_list(0), poolManager2);
+			//claujson::Compact(&ut, poolManager, claujson::NodeOrder::DFS);
 			
 			//poolManager.Clear();
 
@@ -123,13 +198,14 @@ int main(int argc, char* argv[])
 			}
 		}
 		*/
-		bool ok = nullptr != x.first;
+		bool ok = x.first;
 
 		//ut.remove_all(poolManager);
+		poolManager.DestroyNodes(); // edits can move container records to the heap.
 		poolManager.Clear();
 
 
-		return !ok;
+		return !ok ? 1 : (checked ? 0 : 3);
 	}
 	catch (...) {
 		return 1;
@@ -8,8 +8,79 @@
 #include "simdjson/portability.h"
 #include <cstdio>
 #include <climits>
+#include <new>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace simdjson {
+namespace internal {
+
+inline char *allocate_huge_pages(size_t len, dom::huge_page_mode mode, size_t &mapped_len) noexcept {
+  mapped_len = 0;
+#if !defined(_WIN32)
+  if (mode == dom::huge_page_mode::off) { return nullptr; }
+  const size_t total_len = (len + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  if (total_len == 0) { return nullptr; }
+#ifdef MAP_HUGETLB
+  if (mode == dom::huge_page_mode::hugetlb) {
+    void *p = ::mmap(nullptr, total_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      mapped_len = total_len;
+      return static_cast<char *>(p);
+    }
+  }
+#endif
+  // map one huge page more, then cut it to a 2 MB aligned range. (only aligned 2 MB can be a huge page)
+  void *p = ::mmap(nullptr, total_len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) { return nullptr; }
+  char *start = static_cast<char *>(p);
+  char *aligned = start + (HUGE_PAGE_SIZE - reinterpret_cast<uintptr_t>(start) % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+  if (aligned > start) { ::munmap(start, size_t(aligned - start)); }
+  const size_t tail = size_t(start + total_len + HUGE_PAGE_SIZE - (aligned + total_len));
+  if (tail > 0) { ::munmap(aligned + total_len, tail); }
+  advise_huge_pages(aligned, total_len);
+  mapped_len = total_len;
+  return aligned;
+#else
+  (void)len; (void)mode;
+  return nullptr;
+#endif
+}
+
+inline void advise_huge_pages(void *p, size_t len) noexcept {
+#if !defined(_WIN32) && defined(MADV_HUGEPAGE)
+  const size_t page = size_t(::sysconf(_SC_PAGESIZE));
+  const uintptr_t begin = (reinterpret_cast<uintptr_t>(p) + page - 1) / page * page;
+  const uintptr_t end = (reinterpret_cast<uintptr_t>(p) + len) / page * page;
+  if (end > begin) { ::madvise(reinterpret_cast<void *>(begin), size_t(end - begin), MADV_HUGEPAGE); }
+#else
+  (void)p; (void)len;
+#endif
+}
+
+template<typename ParallelFor>
+inline void prefault(char *p, size_t len, size_t chunk_num, ParallelFor &&parallel_for) noexcept {
+  const size_t page = 4096;
+  if (!p || len == 0) { return; }
+  // at least one huge page per thread.
+  if (chunk_num > len / HUGE_PAGE_SIZE) { chunk_num = len / HUGE_PAGE_SIZE; }
+  if (chunk_num < 1) { chunk_num = 1; }
+  const size_t chunk = (len / chunk_num + page - 1) / page * page;
+  parallel_for(chunk_num, [&](size_t i) {
+    volatile char *q = p;
+    const size_t end = chunk * (i + 1) < len ? chunk * (i + 1) : len;
+    for (size_t x = chunk * i; x < end; x += page) {
+      q[x] = q[x];
+    }
+  });
+}
+
+} // namespace internal
+
 namespace dom {
 
 //
@@ -20,7 +91,17 @@ simdjson_really_inline parser::parser(size_t max_capacity) noexcept
     loaded_bytes(nullptr) {
 }
 simdjson_really_inline parser::parser(parser &&other) noexcept = default;
-simdjson_really_inline parser &parser::operator=(parser &&other) noexcept = default;
+simdjson_really_inline parser &parser::operator=(parser &&other) noexcept {
+  // not the default: it would delete[] the huge pages lent to doc and implementation.
+  if (this != &other) {
+    this->~parser();
+    new (this) parser(std::move(other));
+  }
+  return *this;
+}
+inline parser::~parser() noexcept {
+  return_huge_pages();
+}
 
 inline bool parser::is_valid() const noexcept { return valid; }
 inline int parser::get_error_code() const noexcept { return error; }
@@ -61,13 +142,9 @@ inline simdjson_result<size_t> parser::read_file(const std::string &path) noexce
 #endif
 
   // Make sure we have enough capacity to load the file
-  if (_loaded_bytes_capacity < size_t(len)) {
-    loaded_bytes.reset( internal::allocate_padded_buffer(len) );
-    if (!loaded_bytes) {
-      std::fclose(fp);
-      return MEMALLOC;
-    }
-    _loaded_bytes_capacity = len;
+  if (allocate_loaded_bytes(size_t(len)) != SUCCESS) {
+    std::fclose(fp);
+    return MEMALLOC;
   }
 
   // Read the string
@@ -80,9 +157,120 @@ inline simdjson_result<size_t> parser::read_file(const std::string &path) noexce
   return bytes_read;
 }
 
+inline error_code parser::allocate_loaded_bytes(size_t len) noexcept {
+  if (loaded_bytes && _loaded_bytes_capacity >= len) { return SUCCESS; }
+  if (_huge_pages != huge_page_mode::off) {
+    size_t mapped_len = 0;
+    char *p = internal::allocate_huge_pages(len + SIMDJSON_PADDING, _huge_pages, mapped_len);
+    if (p) {
+      loaded_bytes = loaded_bytes_ptr(p, internal::loaded_bytes_deleter{mapped_len});
+      _loaded_bytes_capacity = len;
+      return SUCCESS;
+    }
+  }
+  // assign, not reset(): a mapped file keeps its deleter on reset().
+  loaded_bytes = loaded_bytes_ptr( internal::allocate_padded_buffer(len) );
+  if (!loaded_bytes) {
+    _loaded_bytes_capacity = 0;
+    return MEMALLOC;
+  }
+  _loaded_bytes_capacity = len;
+  return SUCCESS;
+}
+
+template<typename ParallelFor>
+inline void parser::lend_huge_pages(size_t chunk_num, ParallelFor &&parallel_for) noexcept {
+  // the sizes document::allocate() and implementation->allocate() use.
+  const size_t string_len = SIMDJSON_ROUNDUP_N(5 * doc.capacity() / 3 + SIMDJSON_PADDING, 64);
+  const size_t index_len = (SIMDJSON_ROUNDUP_N(capacity(), 64) + 2 + 7) * sizeof(uint32_t);
+  // mapped only when too small, and then their page faults happen here on all threads.
+  if (!huge_string_buf || huge_string_buf.get_deleter().mapped_len < string_len) {
+    size_t mapped_len = 0;
+    char *p = internal::allocate_huge_pages(string_len, _huge_pages, mapped_len);
+    huge_string_buf = p ? loaded_bytes_ptr(p, internal::loaded_bytes_deleter{mapped_len}) : loaded_bytes_ptr();
+    internal::prefault(p, string_len, chunk_num, parallel_for);
+  }
+  if (!huge_indexes || huge_indexes.get_deleter().mapped_len < index_len) {
+    size_t mapped_len = 0;
+    char *p = internal::allocate_huge_pages(index_len, _huge_pages, mapped_len);
+    huge_indexes = p ? loaded_bytes_ptr(p, internal::loaded_bytes_deleter{mapped_len}) : loaded_bytes_ptr();
+    internal::prefault(p, index_len, chunk_num, parallel_for);
+  }
+  // no mapping -> the new[] buffers stay, as in allocate_loaded_bytes().
+  if (huge_string_buf && doc.string_buf) {
+    lent_string_buf.reset(doc.string_buf.release());
+    doc.string_buf.reset(reinterpret_cast<uint8_t *>(huge_string_buf.get()));
+  }
+  if (huge_indexes && implementation->structural_indexes) {
+    lent_indexes.reset(implementation->structural_indexes.release());
+    implementation->structural_indexes.reset(reinterpret_cast<uint32_t *>(huge_indexes.get()));
+  }
+}
+
+inline void parser::return_huge_pages() noexcept {
+  if (huge_string_buf && doc.string_buf.get() == reinterpret_cast<uint8_t *>(huge_string_buf.get())) {
+    doc.string_buf.release();
+    doc.string_buf = std::move(lent_string_buf);
+  }
+  if (huge_indexes && implementation && implementation->structural_indexes.get() == reinterpret_cast<uint32_t *>(huge_indexes.get())) {
+    implementation->structural_indexes.release();
+    implementation->structural_indexes = std::move(lent_indexes);
+  }
+}
+
+inline simdjson_result<size_t> parser::map_file(const std::string &path) noexcept {
+#if !defined(_WIN32)
+  // a mapped file is in the page cache, it cannot be on anonymous huge pages.
+  if (!_use_mmap || _huge_pages != huge_page_mode::off) { return read_file(path); }
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) { return IO_ERROR; }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return IO_ERROR;
+  }
+  // pipes, devices, empty files -> read them.
+  if (!S_ISREG(st.st_mode) || st.st_size <= 0) {
+    ::close(fd);
+    return read_file(path);
+  }
+  const size_t len = size_t(st.st_size);
+
+  const size_t page = size_t(::sysconf(_SC_PAGESIZE));
+  const size_t file_map_len = (len + page - 1) / page * page;
+  const size_t total_len = (len + SIMDJSON_PADDING + page - 1) / page * page;
+
+  // reserve len + padding of zero pages, then map the file over the front.
+  // the rest of the file's last page is zero too.
+  void *p = ::mmap(nullptr, total_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    ::close(fd);
+    return read_file(path);
+  }
+  if (::mmap(p, file_map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    ::munmap(p, total_len);
+    ::close(fd);
+    return read_file(path);
+  }
+  ::close(fd);
+
+#ifdef MADV_WILLNEED
+  ::madvise(p, file_map_len, MADV_WILLNEED);
+#endif
+
+  loaded_bytes = loaded_bytes_ptr(static_cast<char *>(p), internal::loaded_bytes_deleter{total_len});
+  _loaded_bytes_capacity = 0;
+  return len;
+#else
+  return read_file(path);
+#endif
+}
+
 inline simdjson_result<element> parser::load(const std::string &path) & noexcept {
   size_t len;
-  auto _error = read_file(path).get(len);
+  auto _error = map_file(path).get(len);
   if (_error) { return _error; }
   this->len = len;
   return parse(loaded_bytes.get(), len, false);
@@ -96,6 +284,229 @@ inline simdjson_result<document_stream> parser::load_many(const std::string &pat
   return document_stream(*this, reinterpret_cast<const uint8_t*>(loaded_bytes.get()), len, batch_size);
 }
 
+template<typename ParallelFor>
+inline simdjson_result<element> parser::load_parallel(const std::string &path, size_t chunk_num, ParallelFor &&parallel_for) & {
+#if !defined(_WIN32)
+  if (_huge_pages != huge_page_mode::off) {
+    // a new input buffer is faulted in on all threads, before read_file copies into it.
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+      const char *old = loaded_bytes.get();
+      if (allocate_loaded_bytes(size_t(st.st_size)) == SUCCESS && loaded_bytes.get() != old) {
+        internal::prefault(loaded_bytes.get(), size_t(st.st_size) + SIMDJSON_PADDING, chunk_num, parallel_for);
+      }
+    }
+  }
+#endif
+  size_t len;
+  auto _error = map_file(path).get(len);
+  if (_error) { return _error; }
+  this->len = len;
+  _error = stage1_parallel(reinterpret_cast<const uint8_t*>(loaded_bytes.get()), len, chunk_num, parallel_for);
+  if (_error) { return _error; }
+  return doc.root();
+}
+
+inline size_t parser::count_unescaped_quotes(const uint8_t *buf, size_t len, bool escaped) noexcept {
+  size_t count = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (escaped) {
+      escaped = false;
+    } else if (buf[i] == '\\') {
+      escaped = true;
+    } else if (buf[i] == '"') {
+      count++;
+    }
+  }
+  return count;
+}
+
+inline size_t parser::find_stage1_split(const uint8_t *buf, size_t start, size_t last, bool in_string, bool escaped) noexcept {
+  for (size_t i = start; i < last; i++) {
+    if (!in_string) {
+      switch (buf[i - 1]) {
+        case ' ': case '\t': case '\n': case '\r':
+        case '{': case '}': case '[': case ']': case ',': case ':':
+          return i;
+        default:
+          break;
+      }
+    }
+    if (escaped) {
+      escaped = false;
+    } else if (buf[i] == '\\') {
+      escaped = true;
+    } else if (buf[i] == '"') {
+      in_string = !in_string;
+    }
+  }
+  return last + 1;
+}
+
+inline void parser::reserve_stage1_chunks(size_t chunk_num) noexcept {
+  if (chunk_implementations.size() < chunk_num) { chunk_implementations.resize(chunk_num); }
+}
+
+inline error_code parser::stage1_chunk(size_t chunk_idx, const uint8_t *buf, size_t start, size_t len) noexcept {
+  auto &imple = chunk_implementations[chunk_idx];
+  if (len == 0) {
+    if (imple) { imple->n_structural_indexes = 0; }
+    return SUCCESS;
+  }
+  error_code _error = SUCCESS;
+  if (!imple) {
+    _error = simdjson::active_implementation->create_dom_parser_implementation(len, max_depth(), imple);
+  } else if (imple->capacity() < len) {
+    _error = imple->allocate(len, max_depth());
+  }
+  if (_error) { return _error; }
+  _error = imple->stage1(buf + start, len, stage1_mode::regular);
+  if (_error == EMPTY) { // only whitespace
+    imple->n_structural_indexes = 0;
+    return SUCCESS;
+  }
+  return _error;
+}
+
+inline simdjson_result<size_t> parser::load_begin(const std::string &path) noexcept {
+  SIMDJSON_PUSH_DISABLE_WARNINGS
+  SIMDJSON_DISABLE_DEPRECATED_WARNING // Disable CRT_SECURE warning on MSVC: manually verified this is safe
+  loading_file.reset(std::fopen(path.c_str(), "rb"));
+  SIMDJSON_POP_DISABLE_WARNINGS
+
+  if (!loading_file) {
+    return IO_ERROR;
+  }
+
+  // Get the file size
+  if(std::fseek(loading_file.get(), 0, SEEK_END) < 0) {
+    loading_file.reset();
+    return IO_ERROR;
+  }
+#if defined(SIMDJSON_VISUAL_STUDIO) && !SIMDJSON_IS_32BITS
+  __int64 len = _ftelli64(loading_file.get());
+  if(len == -1L) {
+    loading_file.reset();
+    return IO_ERROR;
+  }
+#else
+  long len = std::ftell(loading_file.get());
+  if((len < 0) || (len == LONG_MAX)) {
+    loading_file.reset();
+    return IO_ERROR;
+  }
+#endif
+  std::rewind(loading_file.get());
+
+  if (allocate_loaded_bytes(size_t(len)) != SUCCESS) {
+    loading_file.reset();
+    return MEMALLOC;
+  }
+  error_code _error = ensure_capacity(doc, len);
+  if (_error) {
+    loading_file.reset();
+    return _error;
+  }
+
+  this->len = len;
+  _loaded_len = 0;
+  return size_t(len);
+}
+
+inline simdjson_result<size_t> parser::load_next(size_t max_bytes) noexcept {
+  if (!loading_file) { return size_t(0); }
+  if (max_bytes > len - _loaded_len) { max_bytes = len - _loaded_len; }
+  if (max_bytes == 0) {
+    loading_file.reset();
+    return size_t(0);
+  }
+  size_t bytes_read = std::fread(loaded_bytes.get() + _loaded_len, 1, max_bytes, loading_file.get());
+  if (bytes_read != max_bytes) {
+    loading_file.reset();
+    return IO_ERROR;
+  }
+  _loaded_len += bytes_read;
+  return bytes_read;
+}
+
+template<typename ParallelFor>
+inline error_code parser::stage1_parallel(const uint8_t *buf, size_t len, size_t chunk_num, ParallelFor &&parallel_for) {
+  // string_buf (used by claujson::Convert) and structural_indexes for the whole document.
+  error_code _error = ensure_capacity(doc, len);
+  if (_error) { return _error; }
+  if (_huge_pages != huge_page_mode::off) {
+    lend_huge_pages(chunk_num, parallel_for);
+  }
+
+  if (chunk_num > len / MINIMAL_PARALLEL_STAGE1_CHUNK) { chunk_num = len / MINIMAL_PARALLEL_STAGE1_CHUNK; }
+  if (chunk_num <= 1) {
+    return implementation->stage1(buf, len, stage1_mode::regular);
+  }
+
+  // 1. Raw cuts, never right after a backslash, so no escape sequence crosses a cut.
+  std::vector<size_t> split(chunk_num + 1, 0);
+  for (size_t i = 1; i < chunk_num; i++) {
+    size_t x = len / chunk_num * i;
+    if (x < split[i - 1]) { x = split[i - 1]; }
+    while (x < len && buf[x - 1] == '\\') { x++; }
+    split[i] = x;
+  }
+  split[chunk_num] = len;
+
+  // 2. Are we inside a string at each cut? (parity of the quotes before it)
+  std::vector<uint8_t> quote_odd(chunk_num, 0);
+  parallel_for(chunk_num, [&](size_t i) {
+    quote_odd[i] = uint8_t(count_unescaped_quotes(buf + split[i], split[i + 1] - split[i]) & 1);
+  });
+  std::vector<uint8_t> in_string(chunk_num, 0);
+  for (size_t i = 1; i < chunk_num; i++) {
+    in_string[i] = in_string[i - 1] ^ quote_odd[i - 1];
+  }
+
+  // 3. Move each cut forward to a safe place. A chunk without one is joined to the next chunk.
+  std::vector<size_t> safe_split(split);
+  parallel_for(chunk_num - 1, [&](size_t k) {
+    const size_t i = k + 1;
+    safe_split[i] = find_stage1_split(buf, split[i], split[i + 1], in_string[i] != 0);
+  });
+  for (size_t i = chunk_num - 1; i >= 1; i--) {
+    if (safe_split[i] > split[i + 1]) { safe_split[i] = safe_split[i + 1]; }
+  }
+
+  // 4. Stage 1 on each chunk.
+  reserve_stage1_chunks(chunk_num);
+  std::vector<error_code> errors(chunk_num, SUCCESS);
+  parallel_for(chunk_num, [&](size_t i) {
+    errors[i] = stage1_chunk(i, buf, safe_split[i], safe_split[i + 1] - safe_split[i]);
+  });
+  for (size_t i = 0; i < chunk_num; i++) {
+    if (errors[i]) { return error = errors[i]; }
+  }
+
+  // 5. Copy to implementation->structural_indexes, in order, with the chunk offset added.
+  std::vector<size_t> offset(chunk_num + 1, 0);
+  for (size_t i = 0; i < chunk_num; i++) {
+    const size_t n = safe_split[i + 1] > safe_split[i] ? chunk_implementations[i]->n_structural_indexes : 0;
+    offset[i + 1] = offset[i] + n;
+  }
+  parallel_for(chunk_num, [&](size_t i) {
+    const uint32_t base = uint32_t(safe_split[i]);
+    uint32_t *dst = implementation->structural_indexes.get() + offset[i];
+    const uint32_t *src = chunk_implementations[i] ? chunk_implementations[i]->structural_indexes.get() : nullptr;
+    for (size_t k = 0; k < offset[i + 1] - offset[i]; k++) {
+      dst[k] = src[k] + base;
+    }
+  });
+
+  implementation->n_structural_indexes = uint32_t(offset[chunk_num]);
+  if (implementation->n_structural_indexes == 0) { return error = EMPTY; }
+  implementation->structural_indexes[implementation->n_structural_indexes] = uint32_t(len);
+  implementation->structural_indexes[implementation->n_structural_indexes + 1] = uint32_t(len);
+  implementation->structural_indexes[implementation->n_structural_indexes + 2] = 0;
+  implementation->next_structural_index = 0;
+  return SUCCESS;
+}
+
 inline simdjson_result<element> parser::parse_into_document(document& provided_doc, const uint8_t *buf, size_t len, bool realloc_if_needed) & noexcept {
   // Important: we need to ensure that document has enough capacity.
   // Important: It is possible that provided_doc is actually the internal 'doc' within the parser!!!
@@ -103,12 +514,8 @@ inline simdjson_result<element> parser::parse_into_document(document& provided_d
   if (_error) { return _error; }
   if (realloc_if_needed) {
     // Make sure we have enough capacity to copy len bytes
-    if (!loaded_bytes || _loaded_bytes_capacity < len) {
-      loaded_bytes.reset( internal::allocate_padded_buffer(len) );
-      if (!loaded_bytes) {
-        return MEMALLOC;
-      }
-      _loaded_bytes_capacity = len;
+    if (allocate_loaded_bytes(len) != SUCCESS) {
+      return MEMALLOC;
     }
     std::memcpy(static_cast<void *>(loaded_bytes.get()), buf, len);
   }
@@ -164,12 +571,26 @@ simdjson_really_inline size_t parser::capacity() const noexcept {
 simdjson_really_inline size_t parser::max_capacity() const noexcept {
   return _max_capacity;
 }
+inline size_t parser::input_bytes() const noexcept {
+  if (!loaded_bytes) { return 0; }
+  if (loaded_bytes.get_deleter().mapped_len) { return loaded_bytes.get_deleter().mapped_len; }
+  return _loaded_bytes_capacity + SIMDJSON_PADDING;
+}
+inline size_t parser::stage1_bytes() const noexcept {
+  size_t n = capacity() * sizeof(uint32_t); // structural_indexes
+  if (doc.string_buf) { n += 5 * doc.capacity() / 3 + SIMDJSON_PADDING; }
+  for (auto &imple : chunk_implementations) {
+    if (imple) { n += imple->capacity() * sizeof(uint32_t); }
+  }
+  return n;
+}
 simdjson_really_inline size_t parser::max_depth() const noexcept {
   return implementation ? implementation->max_depth() : DEFAULT_MAX_DEPTH;
 }
 
 simdjson_warn_unused
 inline error_code parser::allocate(size_t capacity, size_t max_depth) noexcept {
+  return_huge_pages();
   //
   // Reallocate implementation if needed
   //
@@ -205,6 +626,7 @@ inline error_code parser::ensure_capacity(document& target_document, size_t desi
   //
   // Note: we must make sure that this function is called if capacity() == 0. We do so because we
   // ensure that desired_capacity > 0.
+  return_huge_pages();
   if (simdjson_unlikely(capacity() < desired_capacity || target_document.capacity() < desired_capacity)) {
     if (desired_capacity > max_capacity()) {
       return error = CAPACITY;
@@ -8,12 +8,61 @@
 #include "simdjson/internal/tape_ref.h"
 #include "simdjson/padded_string.h"
 #include "simdjson/portability.h"
+#include <cstdio>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
 
 namespace simdjson {
 
+namespace dom {
+/**
+ * How big buffers are backed (see parser::set_huge_pages()).
+ */
+enum class huge_page_mode {
+  off,         ///< normal pages (heap or mapped file)
+  transparent, ///< anonymous memory aligned to 2 MB with madvise(MADV_HUGEPAGE)
+  hugetlb      ///< MAP_HUGETLB (reserved 2 MB pages), transparent if none are available
+};
+} // namespace dom
+
+namespace internal {
+/** The size of a huge page. */
+static constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+/**
+ * len bytes (rounded up to HUGE_PAGE_SIZE) of zeroed anonymous memory backed by huge pages,
+ * free it with munmap(p, mapped_len). nullptr if not possible (e.g. on Windows).
+ */
+inline char *allocate_huge_pages(size_t len, dom::huge_page_mode mode, size_t &mapped_len) noexcept;
+/** madvise(MADV_HUGEPAGE) for the whole pages in [p, p + len). */
+inline void advise_huge_pages(void *p, size_t len) noexcept;
+/**
+ * Touch every page of [p, p + len) on chunk_num threads, so the page faults happen now and not
+ * in the first pass over the buffer. The contents are not changed.
+ */
+template<typename ParallelFor>
+inline void prefault(char *p, size_t len, size_t chunk_num, ParallelFor &&parallel_for) noexcept;
+
+/**
+ * Frees the parser's loaded bytes: delete[] for a buffer from allocate_padded_buffer(),
+ * munmap() for a file mapped by parser::map_file() (mapped_len != 0).
+ */
+struct loaded_bytes_deleter {
+  size_t mapped_len{0};
+  inline void operator()(char *p) const noexcept {
+#if !defined(_WIN32)
+    if (mapped_len) { munmap(p, mapped_len); return; }
+#endif
+    delete[] p;
+  }
+};
+} // namespace internal
+
 namespace dom {
 
 class document_stream;
@@ -36,6 +85,11 @@ static constexpr size_t MINIMAL_BATCH_SIZE = 32;
  */
 static constexpr size_t MINIMAL_DOCUMENT_CAPACITY = 32;
 
+/**
+ * parser.load_parallel() does not give a thread less than this many bytes.
+ */
+static constexpr size_t MINIMAL_PARALLEL_STAGE1_CHUNK = 1 << 16;
+
 /**
  * A persistent document parser.
  *
@@ -64,7 +118,10 @@ public:
         return doc.tape;
     }
 
-    inline const std::unique_ptr<char[]>& raw_buf() const noexcept {
+    /** The loaded bytes, heap allocated or a mapped file (see set_mmap()). */
+    using loaded_bytes_ptr = std::unique_ptr<char[], internal::loaded_bytes_deleter>;
+
+    inline const loaded_bytes_ptr& raw_buf() const noexcept {
         return loaded_bytes;
     }
 
@@ -109,7 +166,7 @@ public:
   parser &operator=(const parser &) = delete; ///< @private Disallow copying
 
   /** Deallocate the JSON parser. */
-  ~parser()=default;
+  inline ~parser() noexcept;
 
   /**
    * Load a JSON document from a file and return a reference to it.
@@ -120,6 +177,11 @@ public:
    * The function is eager: the file's content is loaded in memory inside the parser instance
    * and immediately parsed. The file can be deleted after the  `parser.load` call.
    *
+   * Unless set_mmap(false) was called, regular files are memory-mapped (read-only pages, copy on
+   * write) instead of being copied into a heap buffer; the SIMDJSON_PADDING bytes after the end
+   * are zero pages mapped past the file. The file must not be truncated while the document
+   * is used: reading a page past the new end raises SIGBUS.
+   *
    * ### IMPORTANT: Document Lifetime
    *
    * The JSON document still lives in the parser: this is the most efficient way to parse JSON
@@ -147,6 +209,95 @@ public:
    */
   inline simdjson_result<element> load(const std::string &path) & noexcept;
   inline simdjson_result<element> load(const std::string &path) &&  = delete ;
+  /**
+   * Load a JSON document from a file, running stage 1 (structural indexing) on several threads.
+   *
+   * The buffer is cut into chunk_num chunks. Each cut is moved to a point outside of any string,
+   * right after whitespace or a structural character, so every chunk can be indexed on its own.
+   * The indexes of all chunks are then written, in order, into the parser's implementation
+   * (raw_implementation()->structural_indexes). Stage 2 is not run.
+   *
+   *   parser.load_parallel(path, 8, [&](size_t n, const auto &f) {
+   *     // call f(0) .. f(n - 1), possibly concurrently, and return when all are done.
+   *   });
+   *
+   * Small inputs (less than chunk_num * MINIMAL_PARALLEL_STAGE1_CHUNK bytes) use fewer chunks.
+   *
+   * @param path The path to load.
+   * @param chunk_num The number of chunks, usually the number of threads.
+   * @param parallel_for Callable as parallel_for(size_t n, const F &f).
+   * @return The document, or an error (see load()).
+   */
+  template<typename ParallelFor>
+  inline simdjson_result<element> load_parallel(const std::string &path, size_t chunk_num, ParallelFor &&parallel_for) &;
+  template<typename ParallelFor>
+  inline simdjson_result<element> load_parallel(const std::string &path, size_t chunk_num, ParallelFor &&parallel_for) && = delete;
+  /**
+   * Run stage 1 on a padded buffer (len + SIMDJSON_PADDING bytes) on several threads. See load_parallel().
+   */
+  template<typename ParallelFor>
+  inline error_code stage1_parallel(const uint8_t *buf, size_t len, size_t chunk_num, ParallelFor &&parallel_for);
+
+  /**
+   * Incremental loading, for pipelines that index a file while it is still being read.
+   *
+   *   size_t len;
+   *   auto error = parser.load_begin(path).get(len); // allocates raw_buf() and the indexes for len bytes
+   *   size_t n;
+   *   while (!(error = parser.load_next(block_size).get(n)) && n > 0) {
+   *     // raw_buf()[0, loaded_len()) can be used now, e.g. with stage1_chunk().
+   *   }
+   *
+   * load_next() returns 0 (and closes the file) once the whole file is read.
+   */
+  inline simdjson_result<size_t> load_begin(const std::string &path) noexcept;
+  /** Read up to max_bytes more of the file started by load_begin(), appended to raw_buf(). */
+  inline simdjson_result<size_t> load_next(size_t max_bytes) noexcept;
+  /** How many bytes of the current file are in raw_buf(). */
+  simdjson_really_inline size_t loaded_len() const noexcept { return _loaded_len; }
+
+  /**
+   * Whether load() and load_parallel() memory-map the file (default: true, where mmap() is available).
+   * load_begin() / load_next() and load_many() always read into a heap buffer.
+   */
+  simdjson_really_inline void set_mmap(bool enabled) noexcept { _use_mmap = enabled; }
+  simdjson_really_inline bool mmap_enabled() const noexcept { return _use_mmap; }
+
+  /**
+   * Back the input buffer with huge pages (default: off). Files are read, not mapped, then.
+   * load_parallel() also puts string_buf and structural_indexes on huge pages, and
+   * pre-faults them on all threads when they are mapped.
+   */
+  simdjson_really_inline void set_huge_pages(huge_page_mode mode) noexcept { _huge_pages = mode; }
+  simdjson_really_inline huge_page_mode huge_pages() const noexcept { return _huge_pages; }
+
+  /** Make sure stage1_chunk() can be called with chunk_idx < chunk_num. Not thread safe. */
+  inline void reserve_stage1_chunks(size_t chunk_num) noexcept;
+  /**
+   * Run stage 1 on buf[start, start + len) into the chunk's own buffers (raw_chunk_implementation(chunk_idx)),
+   * the indexes are relative to start. start must be outside of any string and right after whitespace or a
+   * structural character (see find_stage1_split). Different chunk_idx can be run at the same time.
+   */
+  inline error_code stage1_chunk(size_t chunk_idx, const uint8_t *buf, size_t start, size_t len) noexcept;
+  inline const std::unique_ptr<internal::dom_parser_implementation>& raw_chunk_implementation(size_t chunk_idx) const noexcept {
+    return chunk_implementations[chunk_idx];
+  }
+
+  /** Bytes of the input buffer: the heap buffer with padding, or the mapped length (mapped file, huge pages). */
+  inline size_t input_bytes() const noexcept;
+  /**
+   * Bytes of the stage 1 buffers: structural_indexes, string_buf and the buffers of stage1_chunk().
+   * The tape is not counted, stage 1 does not write it.
+   */
+  inline size_t stage1_bytes() const noexcept;
+
+  /** Number of quotes not escaped by a backslash in buf[0, len). escaped : buf[0] follows an escaping backslash. */
+  static inline size_t count_unescaped_quotes(const uint8_t *buf, size_t len, bool escaped = false) noexcept;
+  /**
+   * First position in [start, last) that is outside of a string and right after whitespace or a
+   * structural character, or last + 1 if there is none. in_string, escaped : the state at start.
+   */
+  static inline size_t find_stage1_split(const uint8_t *buf, size_t start, size_t last, bool in_string, bool escaped = false) noexcept;
   /**
    * Parse a JSON document and return a temporary reference to it.
    *
@@ -588,11 +739,35 @@ private:
   /**
    * The loaded buffer (reused each time load() is called)
    */
-  std::unique_ptr<char[]> loaded_bytes;
+  loaded_bytes_ptr loaded_bytes;
 
-  /** Capacity of loaded_bytes buffer. */
+  /** Capacity of loaded_bytes buffer. 0 if loaded_bytes is a mapped file, it cannot be reused. */
   size_t _loaded_bytes_capacity{0};
 
+  /** load() and load_parallel() use map_file() */
+  bool _use_mmap{true};
+
+  /** loaded_bytes (and load_parallel()'s buffers) on huge pages */
+  huge_page_mode _huge_pages{huge_page_mode::off};
+
+  /**
+   * stage1_parallel()'s string_buf and structural_indexes on huge pages (reused each time). They are
+   * lent to doc and implementation, whose own buffers wait in lent_string_buf and lent_indexes.
+   */
+  loaded_bytes_ptr huge_string_buf{};
+  loaded_bytes_ptr huge_indexes{};
+  std::unique_ptr<uint8_t[]> lent_string_buf{};
+  std::unique_ptr<uint32_t[]> lent_indexes{};
+
+  /** Per chunk stage 1 buffers for stage1_parallel() (reused each time) */
+  std::vector<std::unique_ptr<internal::dom_parser_implementation>> chunk_implementations{};
+
+  /** File being read by load_begin() / load_next() */
+  std::unique_ptr<std::FILE, int(*)(std::FILE *)> loading_file{nullptr, &std::fclose};
+
+  /** Bytes of the file being read that are in loaded_bytes */
+  size_t _loaded_len{0};
+
   // all nodes are stored on the doc.tape using a 64-bit word.
   //
   // strings, double and ints are stored as
@@ -623,6 +798,18 @@ private:
   /** Read the file into loaded_bytes */
   inline simdjson_result<size_t> read_file(const std::string &path) noexcept;
 
+  /** Map the file as loaded_bytes, with zeroed padding. Falls back to read_file(). */
+  inline simdjson_result<size_t> map_file(const std::string &path) noexcept;
+
+  /** Make loaded_bytes a heap buffer of at least len (+ padding) bytes. */
+  inline error_code allocate_loaded_bytes(size_t len) noexcept;
+
+  /** Swap huge page buffers for the current capacity into doc.string_buf and implementation->structural_indexes. */
+  template<typename ParallelFor>
+  inline void lend_huge_pages(size_t chunk_num, ParallelFor &&parallel_for) noexcept;
+  /** Give doc and implementation their own buffers back, before they are reallocated or deleted. */
+  inline void return_huge_pages() noexcept;
+
   friend class parser::Iterator;
   friend class document_stream;
 